@@ -0,0 +1,102 @@
+#pragma once
+
+#include <agi/array_view.h>
+#include <agi/mapped_file.h>
+#include <agi/resource_type.h>
+#include <boost/filesystem.hpp>
+#include <array>
+#include <memory>
+#include <stdint.h>
+
+namespace agi {
+
+class StringArena;
+struct Script;
+struct View;
+
+/**
+ * \class   GameArchive
+ * \brief   A whole game stored in a single file, which is created from the
+ *          directory and volume files by WriteGameArchive.
+ *
+ *          All values are little-endian and every resource starts on a 16
+ *          byte boundary. The file starts with the header and the index:
+ *
+ *              char[4] magic "AGIA", u32 version, u32 count, u32 indexOffset
+ *              count * { u8 type, u8 number, u16 zero, u32 offset, u32 size }
+ *
+ *          Pictures are stored as the raw picture commands. Logics and views
+ *          are stored already decoded, with all offsets relative to the start
+ *          of the resource:
+ *
+ *              logic:  u32 codeOffset, u32 codeSize, u32 messageCount,
+ *                      messageCount * u32 (offset of a null-terminated and
+ *                      decrypted message, or zero if there is no message)
+ *              view:   u32 loopCount, loopCount * { u32 celCount, u32 celOffset }
+ *              cel:    u8 width, u8 height, u8 flags, u8 zero, u32 pixelOffset
+ *
+ *          The cel pixels are stored as width * height bytes.
+ */
+class GameArchive
+{
+public:
+    enum {
+        kVersion = 1,
+        kAlignment = 16
+    };
+
+    /**
+     * \brief   Maps the archive and validates the index, the resources
+     *          themselves are never copied.
+     */
+    explicit GameArchive(const boost::filesystem::path& filename);
+
+    /**
+     * \brief   Returns true if the archive contains the resource
+     */
+    bool Contains(ResourceType type, uint8_t index) const noexcept;
+
+    /**
+     * \brief   Returns the data of a resource, throws std::invalid_argument
+     *          if the archive doesn't contain the resource.
+     */
+    array_view<uint8_t> GetResource(ResourceType type, uint8_t index) const;
+
+    /**
+     * \brief   Creates a script that refers to the archive data, the archive
+     *          must outlive the script. The message table is allocated
+     *          from the arena.
+     */
+    std::shared_ptr<Script> LoadScript(uint8_t index, StringArena& strings) const;
+
+    /**
+     * \brief   Creates a view where the cels refers to the archive data, the
+     *          archive must outlive the view.
+     */
+    std::shared_ptr<View> LoadView(uint8_t index) const;
+
+private:
+    MappedFile file_;
+    std::array<std::array<array_view<uint8_t>, 256>, kResourceTypes> resources_;
+};
+
+/**
+ * \struct  ArchiveSummary
+ */
+struct ArchiveSummary
+{
+    size_t logics = 0;
+    size_t pictures = 0;
+    size_t views = 0;
+    size_t skipped = 0;     // resources that could not be parsed
+};
+
+/**
+ * \brief   Converts the game in a directory into a single archive file.
+ *          Resources that can't be parsed are left out of the archive.
+ */
+ArchiveSummary WriteGameArchive(
+    const boost::filesystem::path& gameDirectory,
+    const boost::filesystem::path& archiveFile);
+
+} // namespace agi
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <list>
+#include <memory>
+#include <stdint.h>
+
+namespace agi {
+
+/**
+ * \struct  CacheStatistics
+ */
+struct CacheStatistics
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;        // the current size in bytes
+};
+
+/**
+ * \class   ResourceCache
+ * \brief   Least recently used cache of resources, keyed by the resource
+ *          number. Entries are evicted when the total size exceeds the
+ *          budget, except for the entries that are referenced outside the
+ *          cache, which are pinned until the last reference is released.
+ */
+template<class T>
+class ResourceCache
+{
+public:
+    /**
+     * \brief   Constructor, a budget of zero means that the size is unbounded
+     */
+    explicit ResourceCache(size_t budget = 0) :
+        budget_(budget)
+    {
+        // empty
+    }
+
+    /**
+     * \brief   Returns the cached resource, or nullptr if it's not cached
+     */
+    std::shared_ptr<T> Find(uint8_t index)
+    {
+        auto& slot = slots_[index];
+        if (!slot.value) {
+            ++statistics_.misses;
+            return nullptr;
+        }
+        ++statistics_.hits;
+        // most recently used
+        order_.splice(order_.begin(), order_, slot.position);
+        return slot.value;
+    }
+
+    /**
+     * \brief   Returns the cached resource, or nullptr if it's not cached,
+     *          without counting it as a use.
+     */
+    std::shared_ptr<T> Peek(uint8_t index) const
+    {
+        return slots_[index].value;
+    }
+
+    /**
+     * \brief   Adds a resource to the cache, and evicts the least recently
+     *          used resources that aren't pinned until the cache fits
+     *          inside the budget again.
+     */
+    void Insert(uint8_t index, std::shared_ptr<T> value, size_t size)
+    {
+        Erase(index);
+        auto& slot = slots_[index];
+        slot.value = std::move(value);
+        slot.size = size;
+        order_.push_front(index);
+        slot.position = order_.begin();
+        statistics_.size += size;
+        Trim();
+    }
+
+    /**
+     * \brief   Removes a resource from the cache. Anyone still referencing
+     *          the resource keeps it alive.
+     */
+    void Erase(uint8_t index)
+    {
+        auto& slot = slots_[index];
+        if (slot.value) {
+            order_.erase(slot.position);
+            statistics_.size -= slot.size;
+            slot.value.reset();
+            slot.size = 0;
+        }
+    }
+
+    /**
+     * \brief   Removes a resource from the cache, unless it's still
+     *          referenced outside the cache.
+     */
+    void Release(uint8_t index)
+    {
+        if (slots_[index].value.use_count() == 1) {
+            Erase(index);
+        }
+    }
+
+    size_t GetBudget() const noexcept { return budget_; }
+
+    const CacheStatistics& GetStatistics() const noexcept { return statistics_; }
+
+    /**
+     * \brief   Evicts the least recently used resources that aren't pinned,
+     *          until the cache fits inside the budget.
+     */
+    void Trim()
+    {
+        if (!budget_) {
+            return;
+        }
+        auto it = order_.end();
+        while((statistics_.size > budget_) && (it != order_.begin())) {
+            --it;
+            auto& slot = slots_[*it];
+            if (slot.value.use_count() > 1) {
+                // still in use, so it's pinned
+                continue;
+            }
+            statistics_.size -= slot.size;
+            slot.value.reset();
+            slot.size = 0;
+            it = order_.erase(it);
+            ++statistics_.evictions;
+        }
+    }
+
+private:
+    struct Slot
+    {
+        std::shared_ptr<T> value;
+        size_t size = 0;
+        std::list<uint8_t>::iterator position;
+    };
+
+    const size_t budget_;
+    std::array<Slot, 256> slots_;
+    std::list<uint8_t> order_;      // most recently used first
+    CacheStatistics statistics_;
+};
+
+} // namespace agi
@@ -1,4 +1,5 @@
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 
 namespace agi {
@@ -194,8 +195,37 @@ enum class ActionCommand {
     kMax
 };
 
+/**
+ * \brief   Returns true for the commands that can be executed
+ */
+inline bool IsCommandValid(uint8_t command)
+{
+    return command < static_cast<uint8_t>(ActionCommand::kMax);
+}
+
 CommandType GetCommandType(uint8_t command);
 
+/**
+ * \brief   Returns the number of argument bytes that follows a command
+ */
+size_t GetNumberOfArguments(uint8_t command);
+
+/**
+ * \brief   Returns true for the known test commands
+ */
+bool IsConditionValid(uint8_t condition);
+
+/**
+ * \brief   Returns the number of argument bytes that follows a test command,
+ *          except for said() which has a variable number of arguments.
+ */
+size_t GetNumberOfConditionArguments(uint8_t condition);
+
 const char* GetCommandName(uint8_t index);
 
+/**
+ * \brief   Returns the name of a test command
+ */
+const char* GetConditionName(uint8_t condition);
+
 } // namespace agi
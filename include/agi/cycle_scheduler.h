@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace agi {
+
+/**
+ * \class   CycleScheduler
+ * \brief   Decides when the interpreter cycles run, measured against a
+ *          monotonic clock. A cycle is due one period after the previous
+ *          cycle was due, not one period after it finished, so the time
+ *          spent running and presenting the cycles doesn't slow the game
+ *          down. Cycles that were missed are run back to back, up to a
+ *          limit, after that they are skipped.
+ */
+class CycleScheduler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * \brief   Constructor, at most maxCatchUp cycles are due at once
+     */
+    explicit CycleScheduler(size_t maxCatchUp = 4);
+
+    /**
+     * \brief   Returns the number of cycles that are due now, and schedules
+     *          the next cycle. A period of zero makes a single cycle due
+     *          every time it's called.
+     */
+    size_t GetDueCycles(Clock::time_point now, Clock::duration period);
+
+    /**
+     * \brief   Returns when the next cycle is due
+     */
+    Clock::time_point GetNextCycle() const noexcept { return next_; }
+
+    /**
+     * \brief   Restarts the schedule, the next cycle is due now. Used after
+     *          the cycles have been run without the scheduler.
+     */
+    void Reset(Clock::time_point now);
+
+    /**
+     * \brief   Returns the number of cycles that were skipped since they
+     *          were too late.
+     */
+    uint64_t GetSkippedCycles() const noexcept { return skipped_; }
+
+private:
+    const size_t maxCatchUp_;
+    bool started_ = false;
+    Clock::time_point next_;
+    uint64_t skipped_ = 0;
+};
+
+} // namespace agi
@@ -19,6 +19,14 @@ struct DirectoryEntry
     uint32_t offset : 28;
 };
 
+/**
+ * \brief   Returns true if the entry isn't used, which is stored as 0xFFFFFF
+ */
+inline bool IsMissing(const DirectoryEntry& entry)
+{
+    return (entry.volume == 0x0f) && (entry.offset == 0xfffff);
+}
+
 /**
  * \brief   Parses a directory file
  */
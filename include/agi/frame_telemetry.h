@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+
+namespace agi {
+
+/**
+ * \brief   The parts of a presented frame that are timed
+ */
+enum class FramePhase {
+    kCycle,         // the logics and the object updates of the cycle
+    kFinishCycle,   // finishing the cycle and painting the scene
+    kConvert,       // converting the framebuffer into pixels
+    kUpload,        // uploading the pixels into textures
+    kPresent,       // rendering and presenting
+    kMax
+};
+
+enum {
+    kFramePhases = static_cast<size_t>(FramePhase::kMax)
+};
+
+const char* GetFramePhaseName(FramePhase phase);
+
+/**
+ * \struct  FrameTimings
+ */
+struct FrameTimings
+{
+    std::array<uint32_t, kFramePhases> phases{};    // microseconds
+
+    uint32_t& operator[](FramePhase phase) { return phases[static_cast<size_t>(phase)]; }
+    uint32_t operator[](FramePhase phase) const { return phases[static_cast<size_t>(phase)]; }
+
+    uint32_t GetTotal() const;
+};
+
+/**
+ * \struct  FrameStatistics
+ */
+struct FrameStatistics
+{
+    uint32_t p50 = 0;
+    uint32_t p90 = 0;
+    uint32_t p99 = 0;
+    uint32_t max = 0;
+};
+
+/**
+ * \class   FrameTelemetry
+ * \brief   The timings of the latest frames, kept in a ring buffer. Frames
+ *          are added by a single thread and may be read by any thread
+ *          without locking, a frame that is overwritten while it's read is
+ *          left out.
+ */
+class FrameTelemetry
+{
+public:
+    /**
+     * \brief   Constructor, the capacity is rounded up to a power of two
+     */
+    explicit FrameTelemetry(size_t capacity = 4096);
+
+    /**
+     * \brief   Adds the timings of a frame, only one thread may add frames
+     */
+    void Push(const FrameTimings& timings);
+
+    /**
+     * \brief   Returns the number of frames added so far
+     */
+    uint64_t GetFrameCount() const noexcept { return written_.load(std::memory_order_acquire); }
+
+    /**
+     * \brief   Copies the frames that are still in the ring buffer, the
+     *          oldest first.
+     */
+    std::vector<FrameTimings> GetFrames() const;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> frame;    // the frame number plus one, zero while written
+        std::array<std::atomic<uint32_t>, kFramePhases> phases;
+    };
+
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> written_;
+};
+
+/**
+ * \brief   Returns the percentiles of a phase, or of the whole frame if the
+ *          phase is FramePhase::kMax.
+ */
+FrameStatistics GetFrameStatistics(const std::vector<FrameTimings>& frames, FramePhase phase);
+
+/**
+ * \brief   Counts the frames by their total time, every bucket is width
+ *          microseconds wide and the last bucket also counts all the
+ *          frames that are longer.
+ */
+std::vector<size_t> GetFrameHistogram(
+    const std::vector<FrameTimings>& frames,
+    uint32_t width,
+    size_t buckets);
+
+/**
+ * \brief   Writes one line per frame with the time of every phase, in
+ *          microseconds.
+ */
+void WriteFrameCsv(std::ostream& out, const std::vector<FrameTimings>& frames);
+
+} // namespace agi
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include <stdint.h>
 #include <array>
 #include <assert.h>
@@ -38,7 +39,33 @@ public:
     enum {
         kWidth      = 160,
         kHeight     = 200,
-        kPixelPitch = 320
+        kPixelPitch = 320,                  // the width of the text and the output
+        kTextPitch  = kPixelPitch / 8,      // the text is one bit per pixel
+        kFillBottom = 167   // fills never spread down from this row
+    };
+
+    /**
+     * \struct  DirtyRows
+     * \brief   The rows [top, bottom) that have changed. Changes are added
+     *          as a union, the range grows to cover all of them.
+     */
+    struct DirtyRows
+    {
+        size_t top      = kHeight;
+        size_t bottom   = 0;
+
+        bool IsEmpty() const noexcept { return top >= bottom; }
+
+        void Add(size_t first, size_t last) noexcept {
+            top = std::min(top, first);
+            bottom = std::max(bottom, last);
+        }
+
+        void Add(const DirtyRows& rows) noexcept {
+            if (!rows.IsEmpty()) {
+                Add(rows.top, rows.bottom);
+            }
+        }
     };
 
     Framebuffer();
@@ -55,7 +82,17 @@ public:
     void Display(uint8_t row, uint8_t col, const char* text);
     void ClearLines(uint8_t start, uint8_t stop, uint8_t color);
 
-    const std::array<uint8_t, 64000>& GetPictureBuffer() const noexcept {
+    /**
+     * \brief   Returns the picture at its native resolution, one byte per
+     *          pixel and kWidth pixels per row. The text isn't included.
+     *          Writes through the non-const buffers aren't tracked, the
+     *          rows have to be marked with MarkDirty.
+     */
+    const std::array<uint8_t, 32000>& GetPictureBuffer() const noexcept {
+        return picture_;
+    }
+
+    std::array<uint8_t, 32000>& GetPictureBuffer() noexcept {
         return picture_;
     }
 
@@ -63,54 +100,90 @@ public:
         return priority_;
     }
 
+    std::array<uint8_t, 32000>& GetPriorityBuffer() noexcept {
+        return priority_;
+    }
+
     /**
-     * \brief   Sets a pixel if the new pixel has higher priority
+     * \brief   Returns the text drawn on top of the picture, kPixelPitch
+     *          pixels per row where a set bit is a white pixel. The most
+     *          significant bit of a byte is the leftmost pixel.
      */
-    inline void SetPixelIfHigherPriority(uint8_t x, uint8_t y, uint8_t color, uint8_t priority) {
-        if ((x < kWidth) && (y < kHeight)) {
-            if (priority >= GetPriorityPixel(x, y)) {
-                const size_t colorOffset = (y * kPixelPitch) + (x * 2);
-                const size_t priorityOffset = (y * kWidth) + x;
-                picture_[colorOffset]     = color;
-                picture_[colorOffset + 1] = color;
-                priority_[priorityOffset] = priority;
-            }
-        }
+    const std::array<uint8_t, 8000>& GetTextBuffer() const noexcept {
+        return text_;
     }
 
-    inline void SetHiDPIPixel(size_t x, size_t y, uint8_t color)
-    {
-        if ((x < kPixelPitch) && (y < kHeight)) {
-            size_t offset = (y * kPixelPitch) + x;
-            picture_[offset] = color;
-        }
+    /**
+     * \brief   Replaces the text, in the format of GetTextBuffer
+     */
+    void SetTextBuffer(const uint8_t* text);
+
+    /**
+     * \brief   Returns the rows that have changed since they were last taken
+     */
+    const DirtyRows& GetDirtyRows() const noexcept {
+        return dirty_;
     }
 
-private:
-    inline void SetPixel(uint8_t x, uint8_t y) {
-        if ((x < kWidth) && (y < kHeight)) {
-            if (pictureDraw_) {
-                size_t offset = (y * kPixelPitch) + (x * 2);
-                picture_[offset]     = pictureColor_;
-                picture_[offset + 1] = pictureColor_;
-            }
-            if (priorityDraw_) {
-                size_t offset = (y * kWidth) + x;
-                priority_[offset] = priorityColor_;
-            }
-        }
+    /**
+     * \brief   Returns the rows that have changed and starts over with none
+     */
+    DirtyRows TakeDirtyRows() noexcept {
+        const DirtyRows rows = dirty_;
+        dirty_ = DirtyRows();
+        return rows;
+    }
+
+    /**
+     * \brief   Adds the rows [top, bottom) to the dirty rows
+     */
+    void MarkDirty(size_t top, size_t bottom) noexcept {
+        dirty_.Add(top, bottom);
     }
 
-    inline uint8_t GetPicturePixel(uint8_t x, uint8_t y) const noexcept {
+    /**
+     * \brief   Copies the rows of another framebuffer, the rows that
+     *          differ become dirty.
+     */
+    void CopyRows(const Framebuffer& source, const DirtyRows& rows);
+
+    /**
+     * \brief   Converts the screen into kPixelPitch x kHeight pixels, which
+     *          is where the picture pixels are doubled and the text is drawn
+     *          on top of them. The pitch is in pixels.
+     */
+    template<class Pixel>
+    void Convert(Pixel* pixels, size_t pitch, const Pixel* palette) const {
+        DirtyRows rows;
+        rows.Add(0, kHeight);
+        Convert(pixels, pitch, palette, rows);
+    }
+
+    /**
+     * \brief   Converts only some of the rows, the first of them is written
+     *          to the start of the pixels.
+     */
+    template<class Pixel>
+    void Convert(Pixel* pixels, size_t pitch, const Pixel* palette, const DirtyRows& rows) const;
+
+    /**
+     * \brief   Sets a pixel if the new pixel has higher priority
+     */
+    inline void SetPixelIfHigherPriority(uint8_t x, uint8_t y, uint8_t color, uint8_t priority) {
         if ((x < kWidth) && (y < kHeight)) {
-            size_t offset = (y * kPixelPitch) + (x * 2);
-            return picture_[offset];
-        }
-        else {
-            return 4;
+            const size_t offset = (y * kWidth) + x;
+            if (priority >= priority_[offset]) {
+                picture_[offset] = color;
+                priority_[offset] = priority;
+                if (textRows_[y]) {
+                    ClearText(x, x, y);
+                }
+                dirty_.Add(y, y + 1);
+            }
         }
     }
 
+private:
     inline uint8_t GetPriorityPixel(uint8_t x, uint8_t y) const noexcept {
         if ((x < kWidth) && (y < kHeight)) {
             size_t offset = (y * kWidth) + x;
@@ -121,14 +194,58 @@ private:
         }
     }
 
-    bool CanFill(uint8_t x, uint8_t y);
+    /**
+     * \brief   Clears the text on top of the picture pixels [x1, x2]
+     */
+    inline void ClearText(size_t x1, size_t x2, size_t y) {
+        uint8_t* bits = &text_[y * kTextPitch];
+        for(size_t x = x1 * 2; x <= ((x2 * 2) + 1); ++x) {
+            bits[x >> 3] &= ~(0x80 >> (x & 7));
+        }
+    }
+
+    /**
+     * \brief   Returns true if the picture pixel is white, or if the left
+     *          half of it is covered by text.
+     */
+    inline bool IsWhite(size_t x, size_t y) const noexcept {
+        if (picture_[(y * kWidth) + x] == kWhite) {
+            return true;
+        }
+        return textRows_[y] && (text_[(y * kTextPitch) + (x >> 2)] & (0x80 >> ((x * 2) & 7)));
+    }
+
+    /**
+     * \brief   Fills the white area around a pixel, one span at a time
+     */
+    template<bool PriorityDraw>
+    void FillSpans(uint8_t x, uint8_t y);
+
     void DrawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2);
 
+    /**
+     * \brief   The line drawing, specialized for which of the picture and the
+     *          priority screen that are drawn. A line is drawn as spans
+     *          along its major axis, the spans are inclusive and clipped to
+     *          the screen.
+     */
+    template<bool PictureDraw, bool PriorityDraw>
+    void DrawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2);
+    template<bool PictureDraw, bool PriorityDraw>
+    void DrawHorizontalSpan(uint8_t x1, uint8_t x2, uint8_t y);
+    template<bool PictureDraw, bool PriorityDraw>
+    void DrawVerticalSpan(uint8_t x, uint8_t y1, uint8_t y2);
+
 private:
-    // the actual visible pixels
-    std::array<uint8_t, 64000> picture_;
+    // the picture at its native resolution
+    std::array<uint8_t, 32000> picture_;
     // the priority screen
     std::array<uint8_t, 32000> priority_;
+    // the text on top of the picture, and the rows that may have any text
+    std::array<uint8_t, 8000> text_;
+    std::array<bool, kHeight> textRows_;
+    // the rows that have changed
+    DirtyRows dirty_;
     // the picture color
     uint8_t pictureColor_;
     // the priority color
@@ -138,4 +255,27 @@ private:
     uint8_t priorityDraw_    : 1;
 };
 
+template<class Pixel>
+void Framebuffer::Convert(Pixel* pixels, size_t pitch, const Pixel* palette, const DirtyRows& rows) const
+{
+    const size_t bottom = std::min<size_t>(rows.bottom, kHeight);
+    for(size_t y = rows.top; y < bottom; ++y) {
+        Pixel* row = pixels + ((y - rows.top) * pitch);
+        const uint8_t* picture = &picture_[y * kWidth];
+        for(size_t x = 0; x < kWidth; ++x) {
+            const Pixel color = palette[picture[x] & 0x0f];
+            row[x * 2]       = color;
+            row[(x * 2) + 1] = color;
+        }
+        if (textRows_[y]) {
+            const uint8_t* text = &text_[y * kTextPitch];
+            for(size_t x = 0; x < kPixelPitch; ++x) {
+                if (text[x >> 3] & (0x80 >> (x & 7))) {
+                    row[x] = palette[kWhite];
+                }
+            }
+        }
+    }
+}
+
 } // namespace agi
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <agi/native_module.h>
+#include <agi/picture_loader.h>
+#include <agi/resource_events.h>
+#include <agi/resource_index.h>
+#include <agi/script_loader.h>
+#include <agi/startup_loader.h>
+#include <agi/view_loader.h>
+#include <agi/volume_loader.h>
+#include <boost/filesystem.hpp>
+#include <memory>
+
+namespace agi {
+
+/**
+ * \struct  GameOptions
+ */
+struct GameOptions
+{
+    StartupOptions startup;
+    // the budgets are per game, the caches are shared by all the
+    // interpreters that run the game
+    size_t viewCacheBudget = 0;                     // bytes of decoded views to keep, zero means no limit
+    size_t pictureCacheBudget = 2 * 1024 * 1024;    // bytes of rendered pictures to keep, zero means no limit
+    std::shared_ptr<ResourceEventSink> events;      // receives the resource loads, nullptr ignores them
+    const NativeModule* native = nullptr;           // logics translated by logic2cpp, must outlive the game data
+};
+
+/**
+ * \class   GameData
+ * \brief   The resources of a game, which are shared by all the interpreters
+ *          that runs the game. Every resource is loaded once, on first use,
+ *          and never modified after that, so the loaders may be used from
+ *          several threads at the same time. The mutable state of a game
+ *          is kept by each interpreter.
+ */
+class GameData
+{
+public:
+    /**
+     * \brief   Constructor, the path is either the game directory or a
+     *          game archive created with mkarchive.
+     */
+    GameData(
+        const boost::filesystem::path& path,
+        const GameOptions& options = GameOptions());
+
+    GameData(const GameData&) = delete;
+    GameData& operator=(const GameData&) = delete;
+
+    const ResourceIndex& GetResources() const noexcept { return resources_; }
+
+    ScriptLoader& GetScripts() noexcept { return scripts_; }
+    PictureLoader& GetPictures() noexcept { return pictures_; }
+    ViewLoader& GetViews() noexcept { return views_; }
+
+    /**
+     * \brief   Returns where the time was spent while loading the game
+     */
+    const StartupStats& GetStartupStats() const noexcept { return startupStats_; }
+
+private:
+    GameData(
+        const boost::filesystem::path& path,
+        const GameOptions& options,
+        StartupLoader&& loader);
+
+    VolumeLoader volumes_;
+    ResourceIndex resources_;
+    ScriptLoader scripts_;
+    PictureLoader pictures_;
+    ViewLoader views_;
+    StartupStats startupStats_;
+};
+
+} // namespace agi
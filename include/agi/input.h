@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace agi {
+
+/**
+ * \brief   The keys that the interpreter handles itself, all the other
+ *          keys are only reported to the logics.
+ */
+enum class Key : uint8_t {
+    kOther,
+    kLeft,
+    kUp,
+    kRight,
+    kDown,
+    kMax
+};
+
+/**
+ * \struct  KeyEvent
+ * \brief   A key press, translated from the events of the front-end.
+ */
+struct KeyEvent
+{
+    Key key = Key::kOther;
+    uint8_t code = 0;       // the value the logics sees in the pressed key variable
+};
+
+} // namespace agi
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <agi/array_view.h>
+#include <agi/commands.h>
+#include <vector>
+#include <stdint.h>
+
+namespace agi {
+
+/**
+ * \struct  Condition
+ * \brief   A compiled test command of an if. The conditions of an if are
+ *          stored in sequence and all of them must be true, an or group is
+ *          stored as a kOr condition followed by the tests in the group.
+ */
+struct Condition
+{
+    enum {
+        kOr = 0xfc,             // the test of an or group
+        kMaxArguments = 5
+    };
+
+    uint8_t test;                       // the test command, or kOr
+    bool negate;                        // the result is inverted
+    uint8_t count;                      // kOr: the number of tests in the group
+    uint8_t arguments[kMaxArguments];
+};
+
+/**
+ * \struct  Instruction
+ * \brief   A decoded logic instruction. The arguments are stored inline and
+ *          the jump targets are indices of other instructions, so nothing
+ *          has to be decoded while the logic is executed.
+ */
+struct Instruction
+{
+    enum Kind : uint8_t {
+        kCommand,       // an action command, executed by its handler
+        kIf,            // continues with the target if the condition is false
+        kGoto,          // continues with the target
+        kInvalid        // can't be decoded, throws if it's executed
+    };
+
+    enum {
+        kMaxArguments = 7
+    };
+
+    Kind kind;
+    uint8_t command;                    // the action command
+    uint8_t arguments[kMaxArguments];   // the argument bytes of the command
+    uint32_t condition;                 // kIf: index of the first condition
+    uint32_t conditionCount;            // kIf: the number of conditions
+    uint32_t target;                    // kIf, kGoto: index of the next instruction
+};
+
+/**
+ * \brief   Translates the code of a logic into instructions and the
+ *          conditions of the ifs. A target equal to the number of
+ *          instructions is the end of the logic. The code offset of every
+ *          instruction is stored in offsets, if given. Throws
+ *          std::runtime_error if a jump ends up inside an instruction.
+ */
+void TranslateScript(
+    array_view<uint8_t> code,
+    std::vector<Instruction>& instructions,
+    std::vector<Condition>& conditions,
+    std::vector<uint32_t>* offsets = nullptr);
+
+} // namespace agi
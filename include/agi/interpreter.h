@@ -3,32 +3,35 @@
 #include <agi/commands.h>
 #include <agi/array_view.h>
 #include <agi/object_table.h>
-#include <agi/script_loader.h>
-#include <agi/volume_loader.h>
-#include <agi/picture_loader.h>
-#include <agi/view_loader.h>
+#include <agi/game_data.h>
 #include <agi/framebuffer.h>
+#include <agi/input.h>
+#include <agi/profiler.h>
+#include <agi/snapshot.h>
 #include <agi/uar.h>
 #include <boost/filesystem.hpp>
 #include <boost/optional.hpp>
 #include <bitset>
+#include <chrono>
+#include <random>
 #include <array>
 #include <stdint.h>
 #include <iostream>
-#include <SDL.h>
 
 namespace agi {
 
 struct ExecState {
-    ExecState(std::shared_ptr<Script>&& code) :
+    ExecState(uint8_t number, std::shared_ptr<const Script>&& code) :
+        logic(number),
         script(code),
         ip(0)
     {
         // empty 
     }
 
-    std::shared_ptr<Script> script;
-    size_t ip;                          // instruction pointer in script       
+    uint8_t logic;                      // the logic number of the script
+    std::shared_ptr<const Script> script;
+    size_t ip;                          // index of the next instruction
 };
 
 enum class ControlMode {
@@ -85,6 +88,27 @@ enum class Flag {
     kEnableNonBlockingWindows       = 15
 };
 
+/**
+ * \brief   How Interpreter::ExecuteCommands dispatches the commands, the
+ *          logics always run through the handler table
+ */
+enum class CommandDispatch {
+    kTable,     // a handler table indexed by the command
+    kSwitch     // the switches on the command type and on the command
+};
+
+/**
+ * \struct  InterpreterOptions
+ * \brief   The game options are only used when the interpreter loads the
+ *          game itself, not when it shares already loaded game data.
+ */
+struct InterpreterOptions : GameOptions
+{
+    uint32_t seed = 1;                              // seeds the random numbers of the logics
+    std::shared_ptr<Profiler> profiler;             // only used if built with AGI_ENABLE_PROFILER
+    bool timeFinishCycle = false;                   // measures GetFinishCycleTime
+};
+
 /**
  * \class   Interpreter
  */
@@ -92,27 +116,106 @@ class Interpreter
 {
 public:
     /**
-     * \brief   Constructor
+     * \brief   Constructor, the path is either the game directory or a
+     *          game archive created with mkarchive.
+     */
+    Interpreter(
+        const boost::filesystem::path& path,
+        const InterpreterOptions& options = InterpreterOptions());
+
+    /**
+     * \brief   Constructor, runs a game that is already loaded. The game data
+     *          may be shared by any number of interpreters, on any threads.
+     */
+    Interpreter(
+        std::shared_ptr<GameData> game,
+        const InterpreterOptions& options = InterpreterOptions());
+
+    /**
+     * \brief   Destructor, the resources pinned by the interpreter are
+     *          released to the caches of the game.
      */
-    Interpreter(const boost::filesystem::path& path);
+    ~Interpreter();
 
     /**
      * \brief   Returns the framebuffer associated with the interpreter
      */
     Framebuffer& GetFramebuffer() { return framebuffer_; }
 
+    /**
+     * \brief   Returns where the time was spent while loading the game
+     */
+    const StartupStats& GetStartupStats() const noexcept { return game_->GetStartupStats(); }
+
+    /**
+     * \brief   Returns a checksum of the variables and flags, used to compare
+     *          the state of two interpreters. The clock is not included.
+     */
+    uint64_t GetStateChecksum() const;
+
+    /**
+     * \brief   Captures the state of the interpreter, the framebuffers are
+     *          only included if requested. A snapshot can be restored by any
+     *          interpreter that runs the same game, which forks the game.
+     */
+    Snapshot CaptureSnapshot(uint32_t contents = Snapshot::kState) const;
+
+    /**
+     * \brief   Restores the state from a snapshot. The framebuffers are kept
+     *          as they are if the snapshot doesn't include them. Throws
+     *          std::runtime_error if the snapshot is invalid, in which case
+     *          the state is left unchanged.
+     */
+    void RestoreSnapshot(const Snapshot& snapshot);
+
+    /**
+     * \brief   Returns the hits, misses and evictions of the view cache
+     */
+    CacheStatistics GetViewCacheStatistics() const { return views_.GetStatistics(); }
+
+    /**
+     * \brief   Returns the hits, misses and evictions of the rendered picture cache
+     */
+    CacheStatistics GetPictureCacheStatistics() const { return pictures_.GetStatistics(); }
+
 
     boost::optional<UserActionRequest> StartCycle();
     boost::optional<UserActionRequest> ResumeCycle();
 
+    /**
+     * \brief   Runs a number of cycles back to back, without any delay
+     *          between them. The scene is only painted after the last cycle.
+     *          Returns the number of completed cycles, which is less than
+     *          the count if a cycle requested user action.
+     */
+    size_t RunCycles(size_t count);
+
     unsigned GetCycleDelay() const noexcept;
 
+    /**
+     * \brief   Executes the commands one after the other, outside of any
+     *          logic. The dispatch is chosen once for all of them, so the
+     *          two can be compared without anything else in the way, see
+     *          benchdispatch. The commands must not change the script
+     *          stack.
+     */
+    void ExecuteCommands(const std::vector<Instruction>& commands, CommandDispatch dispatch);
+
+    /**
+     * \brief   Returns the time spent finishing and painting the last cycle,
+     *          which is included in the time of StartCycle. Always zero
+     *          unless InterpreterOptions::timeFinishCycle is set.
+     */
+    std::chrono::microseconds GetFinishCycleTime() const noexcept { return finishCycleTime_; }
+
     /**
      * \brief   Called when a key is pressed
      */
-    void OnKeyPress(SDL_Keysym);
+    void OnKeyPress(const KeyEvent& key);
 
 protected:
+    friend class NativeContext;
+
     boost::optional<UserActionRequest> Cycle();
     void FinishCycle();
     void PaintScene();
@@ -164,20 +267,50 @@ protected:
     void InitializationCommand(uint8_t cmd, const uint8_t* arguments);
     void MenuManagementCommand(uint8_t cmd, const uint8_t* arguments);
     void MiscCommand(uint8_t cmd, const uint8_t* arguments);
-    boost::optional<UserActionRequest> StringManagementCommand(
-        uint8_t cmd, const uint8_t* arguments);
+    void StringManagementCommand(uint8_t cmd, const uint8_t* arguments);
+    void InvalidCommand(uint8_t cmd, const uint8_t* arguments);
+
+    /**
+     * \brief   The handler of a single command, only defined for the
+     *          categories that the logics execute the most. The other
+     *          commands are handled by the switch of their category.
+     */
+    template<ActionCommand command>
+    void Command(uint8_t cmd, const uint8_t* arguments);
+
+    typedef void (Interpreter::*CommandHandler)(uint8_t cmd, const uint8_t* arguments);
+
+    /**
+     * \brief   Returns the handler of every command, created the first time
+     *          it's called.
+     */
+    static const std::array<CommandHandler, 256>& GetCommandHandlers();
+
+    /**
+     * \brief   Executes a command by switching on the command type and then
+     *          on the command, which is how the commands were dispatched
+     *          before the handler table.
+     */
+    void ExecuteCommand(uint8_t cmd, const uint8_t* arguments);
 
     void SetInitialState();
+    void SaveGame();
+    void RestoreGame();
+    void RestartGame();
     void UpdateClock();
     void Execute(std::shared_ptr<Script>);
     void ClearKeyboardBuffer();
     void PollInput();
-    void ExecuteCommand(
-        const Script&, ActionCommand cmd, const uint8_t* arguments, size_t argumentCount);
 
-    bool LogicalAnd(ExecState& state);
-    bool LogicalOr(ExecState& state);
-    bool ProcessSingleCondition(uint8_t condition, ExecState& state);
+    /**
+     * \brief   Returns true if all the conditions of an if are true, stops
+     *          at the first condition that is false.
+     */
+    bool EvaluateConditions(const Condition* conditions, size_t count);
+    bool Test(const Condition& condition);
+#ifdef AGI_ENABLE_PROFILER
+    bool ProfileTest(const Condition& condition);
+#endif
 
     void NewRoom(uint8_t room);
     void Call(uint8_t logicNumber);
@@ -212,21 +345,32 @@ private:
     /*************************************************************************/
     /*                                  Loaders                              */
     /*************************************************************************/
-    VolumeLoader volumes_;
-    ScriptLoader scripts_;
-    PictureLoader pictures_;
-    ViewLoader views_;
+    const std::shared_ptr<GameData> game_;
+    ScriptLoader& scripts_;
+    PictureLoader& pictures_;
+    ViewLoader& views_;
+    // the pictures loaded by the logics are pinned in the shared cache
+    std::array<std::shared_ptr<const Framebuffer>, 256> loadedPictures_;
     Framebuffer pictureBuffer_;
     Framebuffer framebuffer_;
     std::vector<ExecState> scriptStack_;
+    const std::shared_ptr<Profiler> profiler_;
+    const bool timeFinishCycle_;
+    std::chrono::microseconds finishCycleTime_{0};
+    boost::optional<UserActionRequest> request_;    // set by the commands that needs user action
 
-    std::vector<SDL_Keysym> keys_;
+    std::vector<KeyEvent> keys_;
     std::bitset<256> flags_;
     std::bitset<256> roomFlags_;
     std::array<uint8_t, 256> variables_;
     std::array<Object, 256> objects_;
     uint8_t horizon_;
     bool programControl_ = true;
+    bool paintScene_ = true;        // false while running cycles without presenting them
+    bool abandonCycle_ = false;     // the state was restored, so the cycle is not finished
+    Snapshot initialState_;         // restored by restart.game
+    Snapshot savedGame_;            // written by save.game, empty until then
+    std::minstd_rand random_;       // every interpreter has its own random numbers
 };
 
 } // namespace agi
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <agi/array_view.h>
+#include <boost/filesystem.hpp>
+#include <stdint.h>
+#include <vector>
+
+namespace agi {
+
+/**
+ * \class   MappedFile
+ * \brief   A file that is mapped read-only into memory. The data is served
+ *          directly from the page cache, so nothing is copied.
+ */
+class MappedFile
+{
+public:
+    /**
+     * \brief   Maps the file, throws std::invalid_argument if the file does
+     *          not exist and std::runtime_error if it can't be mapped.
+     */
+    explicit MappedFile(const boost::filesystem::path& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * \brief   Returns the mapped data
+     */
+    array_view<uint8_t> GetData() const noexcept {
+        return array_view<uint8_t>(data_, size_);
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+#if defined(_WIN32)
+    // no mmap available, the file is read into memory instead
+    std::vector<uint8_t> buffer_;
+#endif
+};
+
+} // namespace agi
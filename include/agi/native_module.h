@@ -0,0 +1,73 @@
+#pragma once
+
+#include <agi/array_view.h>
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace agi {
+
+class Interpreter;
+
+/**
+ * \class   NativeContext
+ * \brief   The interpreter as seen by a translated logic, the commands and
+ *          tests are executed by the same handlers as the bytecode.
+ */
+class NativeContext
+{
+public:
+    explicit NativeContext(Interpreter& interpreter) :
+        interpreter_(interpreter)
+    {
+        // empty
+    }
+
+    /**
+     * \brief   Executes a command, returns false if the logic must return to
+     *          the interpreter since the command changed the script stack or
+     *          requested user action.
+     */
+    bool Command(uint8_t cmd, const uint8_t* arguments);
+
+    /**
+     * \brief   Evaluates a test command
+     */
+    bool Test(uint8_t test, uint8_t a0 = 0, uint8_t a1 = 0, uint8_t a2 = 0, uint8_t a3 = 0, uint8_t a4 = 0);
+
+private:
+    Interpreter& interpreter_;
+};
+
+/**
+ * \brief   A logic translated into C++ by logic2cpp. It continues from the
+ *          instruction index ip, and sets ip to the instruction that follows
+ *          a command before executing it. After a command that returns false
+ *          ip must not be touched, since it refers to the script stack.
+ */
+typedef void (*NativeLogic)(NativeContext& context, size_t& ip);
+
+/**
+ * \struct  NativeModule
+ * \brief   The translated logics of a game. A logic is only used if the
+ *          checksum matches the code of the loaded logic, otherwise the
+ *          bytecode is interpreted.
+ */
+struct NativeModule
+{
+    struct Logic
+    {
+        NativeLogic function;
+        uint64_t checksum;
+    };
+
+    const char* name;
+    std::array<Logic, 256> logics;
+};
+
+/**
+ * \brief   Returns the checksum of the code of a logic
+ */
+uint64_t GetCodeChecksum(array_view<uint8_t> code);
+
+} // namespace agi
@@ -1,29 +1,57 @@
 #pragma once
 
+#include <agi/cache.h>
 #include <agi/framebuffer.h>
-#include <agi/volume_loader.h>
-#include <agi/directory.h>
-#include <boost/filesystem.hpp>
-#include <vector>
+#include <agi/resource_events.h>
+#include <agi/resource_index.h>
+#include <memory>
+#include <mutex>
 
 namespace agi {
 
 /**
  * \class   PictureLoader
+ * \brief   Draws pictures. The rendered picture and priority screens are
+ *          cached, so drawing a picture again is a single copy. The loader
+ *          may be used from several threads.
  */
 class PictureLoader
 {
 public:
+    /**
+     * \brief   Constructor, the index must outlive the loader. The rendered
+     *          pictures are cached until the cache budget (in bytes) is
+     *          exceeded, zero means that the cache is unbounded. Rendering
+     *          a picture is reported to the event sink, if there is one.
+     */
     PictureLoader(
-        VolumeLoader& volumes,
-        const boost::filesystem::path& directoryFile);
+        const ResourceIndex& resources,
+        size_t cacheBudget,
+        std::shared_ptr<ResourceEventSink> events = nullptr);
+
+    /**
+     * \brief   Renders the picture, it's pinned in the cache for as long as
+     *          the returned picture is referenced.
+     */
+    std::shared_ptr<const Framebuffer> LoadPicture(uint8_t picture);
+
+    /**
+     * \brief   Evicts the pictures that are no longer pinned, if the cache
+     *          exceeds the budget.
+     */
+    void Trim();
 
     void DrawPicture(uint8_t picture, Framebuffer&);
     void OverlayPicture(uint8_t picture, Framebuffer&);
 
+    CacheStatistics GetStatistics() const;
+
 private:
-    VolumeLoader& volumes_;
-    std::vector<DirectoryEntry> entries_;
+    const ResourceIndex& resources_;
+    const std::shared_ptr<ResourceEventSink> events_;
+    const bool reportHits_;                 // asked once, the sink is fixed
+    mutable std::mutex mutex_;
+    ResourceCache<const Framebuffer> cache_;
 };
 
 } // namespace agi
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+
+namespace agi {
+
+/**
+ * \brief   True if the library is built with AGI_ENABLE_PROFILER, otherwise
+ *          the interpreter never reports anything to a profiler and the
+ *          profiling costs nothing.
+ */
+#ifdef AGI_ENABLE_PROFILER
+const bool kProfilerEnabled = true;
+#else
+const bool kProfilerEnabled = false;
+#endif
+
+/**
+ * \class   Profiler
+ * \brief   Counts how many times the commands, the test commands and the
+ *          instructions of every logic are executed, and the time spent in
+ *          them. A profiler must only be used by one interpreter at a time,
+ *          the profilers of several interpreters are combined with Merge.
+ */
+class Profiler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum {
+        kNative = 0xfd      // the instruction where a translated logic started
+    };
+
+    struct Counter
+    {
+        uint64_t count = 0;
+        Clock::duration time = Clock::duration::zero();
+    };
+
+    void AddCommand(uint8_t command, Clock::duration time)
+    {
+        Add(commands_[command], time);
+    }
+
+    void AddTest(uint8_t test, Clock::duration time)
+    {
+        Add(tests_[test], time);
+    }
+
+    /**
+     * \brief   Adds the execution of an instruction, the command is the
+     *          action command, 0xff for an if, 0xfe for a goto or kNative.
+     */
+    void AddInstruction(uint8_t logic, uint32_t offset, uint8_t command, Clock::duration time)
+    {
+        auto& instructions = instructions_[logic];
+        if (offset >= instructions.size()) {
+            instructions.resize(offset + 1);
+        }
+        instructions[offset].command = command;
+        Add(instructions[offset], time);
+    }
+
+    /**
+     * \brief   Adds the counters of another profiler
+     */
+    void Merge(const Profiler& other);
+
+    /**
+     * \brief   Writes the commands, tests, logics and the most expensive
+     *          instructions, sorted by the time spent in them.
+     */
+    void WriteReport(std::ostream& out, size_t maxInstructions = 50) const;
+
+    /**
+     * \brief   Writes all the counters as comma separated values, with the
+     *          columns kind, name, logic, offset, count and time (ns).
+     */
+    void WriteCsv(std::ostream& out) const;
+
+private:
+    struct InstructionCounter : Counter
+    {
+        uint8_t command = 0;
+    };
+
+    static void Add(Counter& counter, Clock::duration time)
+    {
+        ++counter.count;
+        counter.time += time;
+    }
+
+    std::array<Counter, 256> commands_;
+    std::array<Counter, 256> tests_;
+    // indexed by the logic and then by the code offset of the instruction
+    std::array<std::vector<InstructionCounter>, 256> instructions_;
+};
+
+} // namespace agi
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <agi/array_view.h>
+#include <agi/resource_type.h>
+#include <boost/filesystem.hpp>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+namespace agi {
+
+/**
+ * \struct  ResourceEvent
+ * \brief   Reported by the loaders every time a resource is requested.
+ */
+struct ResourceEvent
+{
+    ResourceType type;
+    uint8_t index;
+    bool cacheHit;                              // already loaded, nothing was decoded
+    size_t size = 0;                            // bytes of resource data
+    std::chrono::microseconds decodeTime{0};    // zero for a cache hit
+    array_view<uint8_t> data;                   // the resource data, empty for a cache hit
+};
+
+/**
+ * \class   ResourceEventSink
+ * \brief   Receives the resource events. The views are loaded on several
+ *          threads when prefetching, so a sink must be thread safe.
+ */
+class ResourceEventSink
+{
+public:
+    virtual ~ResourceEventSink() = default;
+
+    virtual void OnResourceEvent(const ResourceEvent& event) = 0;
+
+    /**
+     * \brief   Returns whether the cache hits are reported to the sink. The
+     *          loaders ask once, since a hit happens on every script call.
+     */
+    virtual bool WantsHits() const { return true; }
+};
+
+/**
+ * \class   NullEventSink
+ * \brief   Ignores all events, the default sink of the loaders.
+ */
+class NullEventSink : public ResourceEventSink
+{
+public:
+    void OnResourceEvent(const ResourceEvent&) override {}
+
+    bool WantsHits() const override { return false; }
+};
+
+/**
+ * \struct  ResourceCounters
+ */
+struct ResourceCounters
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t bytes = 0;                         // bytes of resource data that was decoded
+    std::chrono::microseconds decodeTime{0};    // total time spent decoding
+};
+
+/**
+ * \class   CountingEventSink
+ * \brief   Counts the events per resource type.
+ */
+class CountingEventSink : public ResourceEventSink
+{
+public:
+    void OnResourceEvent(const ResourceEvent& event) override;
+
+    ResourceCounters GetCounters(ResourceType type) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::array<ResourceCounters, kResourceTypes> counters_;
+};
+
+/**
+ * \class   DumpEventSink
+ * \brief   Writes the data of every logic that is loaded to scriptN.txt in
+ *          a directory, failing to write a file is ignored.
+ */
+class DumpEventSink : public ResourceEventSink
+{
+public:
+    explicit DumpEventSink(const boost::filesystem::path& directory);
+
+    void OnResourceEvent(const ResourceEvent& event) override;
+
+    bool WantsHits() const override { return false; }
+
+private:
+    const boost::filesystem::path directory_;
+};
+
+/**
+ * \class   FanOutEventSink
+ * \brief   Forwards every event to several sinks, in the order they were
+ *          given. The sinks are fixed at construction.
+ */
+class FanOutEventSink : public ResourceEventSink
+{
+public:
+    explicit FanOutEventSink(std::vector<std::shared_ptr<ResourceEventSink>> sinks);
+
+    void OnResourceEvent(const ResourceEvent& event) override;
+
+    bool WantsHits() const override;
+
+private:
+    const std::vector<std::shared_ptr<ResourceEventSink>> sinks_;
+};
+
+} // namespace agi
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <agi/array_view.h>
+#include <agi/archive.h>
+#include <agi/directory.h>
+#include <agi/resource_type.h>
+#include <agi/volume_loader.h>
+#include <boost/filesystem.hpp>
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace agi {
+
+/**
+ * \struct  ResourceEntry
+ */
+struct ResourceEntry
+{
+    enum State : uint8_t {
+        kMissing,   // not in the directory, or stored as 0xFFFFFF
+        kValid,
+        kInvalid    // the entry doesn't refer to a valid resource
+    };
+
+    State state = kMissing;
+    uint8_t volume = 0;
+    uint32_t offset = 0;
+    array_view<uint8_t> data;   // the resource data, without the 5 byte header
+    std::string error;          // why the entry is invalid
+};
+
+/**
+ * \class   ResourceIndex
+ * \brief   The logics, pictures and views of a game. Every directory entry is
+ *          validated once when the index is created, so a resource can be
+ *          looked up without checking the volume or the resource header.
+ */
+class ResourceIndex
+{
+public:
+    /**
+     * \brief   Parses the directory files in the game directory
+     */
+    ResourceIndex(VolumeLoader& volumes, const boost::filesystem::path& gameDirectory);
+
+    /**
+     * \brief   Constructor, uses already parsed directories
+     */
+    ResourceIndex(
+        VolumeLoader& volumes,
+        const std::vector<DirectoryEntry>& logics,
+        const std::vector<DirectoryEntry>& pictures,
+        const std::vector<DirectoryEntry>& views);
+
+    /**
+     * \brief   Constructor, the resources are stored in a game archive
+     */
+    explicit ResourceIndex(std::shared_ptr<const GameArchive> archive);
+
+    /**
+     * \brief   Returns the entry of a resource, which is kMissing for all
+     *          the indices that are outside the directory.
+     */
+    const ResourceEntry& GetEntry(ResourceType type, uint8_t index) const noexcept {
+        return entries_[static_cast<size_t>(type)][index];
+    }
+
+    /**
+     * \brief   Returns true if the resource exists and is valid
+     */
+    bool Contains(ResourceType type, uint8_t index) const noexcept {
+        return GetEntry(type, index).state == ResourceEntry::kValid;
+    }
+
+    /**
+     * \brief   Returns the data of a resource. Throws std::invalid_argument if
+     *          the resource is missing and std::runtime_error if it's invalid.
+     */
+    array_view<uint8_t> Get(ResourceType type, uint8_t index) const;
+
+    /**
+     * \brief   Returns the game archive, or nullptr if the resources are
+     *          stored in volume files.
+     */
+    const std::shared_ptr<const GameArchive>& GetArchive() const noexcept { return archive_; }
+
+private:
+    void Add(
+        VolumeLoader& volumes,
+        ResourceType type,
+        const std::vector<DirectoryEntry>& entries);
+
+    std::array<std::array<ResourceEntry, 256>, kResourceTypes> entries_;
+    std::shared_ptr<const GameArchive> archive_;
+};
+
+} // namespace agi
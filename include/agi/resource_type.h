@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace agi {
+
+/**
+ * \brief   The types of resources that are loaded by the interpreter
+ */
+enum class ResourceType : uint8_t
+{
+    kLogic      = 0,
+    kPicture    = 1,
+    kView       = 2
+};
+
+enum {
+    kResourceTypes = 3
+};
+
+} // namespace agi
@@ -1,45 +1,74 @@
 #pragma once
 
 #include <agi/array_view.h>
-#include <agi/volume_loader.h>
-#include <agi/directory.h>
-#include <boost/filesystem.hpp>
+#include <agi/instruction.h>
+#include <agi/native_module.h>
+#include <agi/resource_events.h>
+#include <agi/resource_index.h>
+#include <agi/string_arena.h>
 #include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 
 namespace agi {
 
 struct Script
 {
     array_view<uint8_t> code;               // the script code
-    std::vector<char> stringData;           // decrypted string data
-    std::vector<const char*> messages;      // points to null-terminated strings in the string data
+    array_view<const char*> messages;       // null-terminated strings, or nullptr if there is no message
+    std::vector<Instruction> instructions;  // the decoded code
+    std::vector<uint32_t> offsets;          // the code offset of each instruction
+    std::vector<Condition> conditions;      // the compiled conditions of the ifs
+    NativeLogic native = nullptr;           // runs instead of the instructions, if translated
 };
 
+/**
+ * \brief   Parses the data of a logic resource, the code of the returned
+ *          script refers to the data and the messages are decrypted into
+ *          the arena.
+ */
+std::shared_ptr<Script> ParseScript(array_view<uint8_t> data, StringArena& strings);
+
 /**
  * \class   ScriptLoader
+ * \brief   Loads scripts, the loader may be used from several threads. A
+ *          script is never modified once it's loaded, and it's kept for the
+ *          lifetime of the loader.
  */
 class ScriptLoader
 {
 public:
-    ScriptLoader(
-        VolumeLoader& volumes,
-        const boost::filesystem::path& directoryFile);
+    /**
+     * \brief   Constructor, the index must outlive the loader. The loads are
+     *          reported to the event sink, if there is one. The logics in
+     *          the native module replaces the bytecode of matching logics.
+     */
+    explicit ScriptLoader(
+        const ResourceIndex& resources,
+        std::shared_ptr<ResourceEventSink> events = nullptr,
+        const NativeModule* module = nullptr);
 
     /**
      * \brief   Get a specific script
      */
-    std::shared_ptr<Script> GetScript(uint8_t index);
+    std::shared_ptr<const Script> GetScript(uint8_t index);
 
     /**
      * \brief   Loads a script
      */
-    std::shared_ptr<Script> LoadScript(uint8_t);
+    std::shared_ptr<const Script> LoadScript(uint8_t);
 
 protected:
-    VolumeLoader& volumes_;
-    std::array<std::shared_ptr<Script>, 256> scripts_;
-    std::vector<DirectoryEntry> entries_;
+    const ResourceIndex& resources_;
+    const std::shared_ptr<ResourceEventSink> events_;
+    const bool reportHits_;                 // asked once, the sink is fixed
+    const NativeModule* module_;
+    std::mutex mutex_;                      // serializes the loads
+    StringArena strings_;                   // the messages of all the loaded scripts
+    std::array<std::shared_ptr<const Script>, 256> scripts_;
+    // set once the script is stored, after that the slot is only read
+    std::array<std::atomic<bool>, 256> loaded_;
 };
 
 } // namespace agi
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+namespace agi {
+
+/**
+ * \struct  Snapshot
+ * \brief   The mutable state of an interpreter, captured by
+ *          Interpreter::CaptureSnapshot. The state is stored in a versioned
+ *          binary format where all values are little-endian:
+ *
+ *              char[4] magic "AGIS", u32 version, u32 contents
+ *              u8[256] variables, u8[32] flags, u8[32] room flags,
+ *              u8 horizon, u8 program control, u32 random state,
+ *              u16 keyCount, keyCount * { u8 key, u8 code },
+ *              u8[32] loaded pictures,
+ *              256 * object, u16 stackSize, stackSize * { u8 logic, u32 ip }
+ *
+ *          Followed by the picture, priority and text buffers of the
+ *          picture and the screen, if the contents includes the
+ *          framebuffers. The resources are stored as their numbers, and
+ *          are loaded again when the snapshot is restored.
+ */
+struct Snapshot
+{
+    enum {
+        kVersion = 2
+    };
+
+    enum Contents : uint32_t {
+        kState          = 0,
+        kFramebuffers   = (1 << 0)
+    };
+
+    std::vector<uint8_t> data;
+};
+
+} // namespace agi
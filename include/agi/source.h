@@ -86,6 +86,7 @@ public:
 
     size_t GetOffset() const noexcept { return offset_; }
     size_t GetSize() const noexcept { return size_; }
+    const uint8_t* GetBuffer() const noexcept { return buffer_; }
 
 private:
     const uint8_t* buffer_;
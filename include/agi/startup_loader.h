@@ -0,0 +1,81 @@
+#pragma once
+
+#include <agi/archive.h>
+#include <agi/directory.h>
+#include <agi/resource_index.h>
+#include <agi/thread_pool.h>
+#include <boost/filesystem.hpp>
+#include <bitset>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+namespace agi {
+
+class ViewLoader;
+
+/**
+ * \struct  StartupOptions
+ */
+struct StartupOptions
+{
+    bool prefetch = false;          // parse the directories and load every volume up front
+    bool predecodeViews = false;    // also decode every view, only used together with prefetch
+    unsigned threads = 4;           // number of worker threads used when prefetching
+};
+
+/**
+ * \struct  StartupStats
+ * \brief   Where the time was spent while the interpreter was constructed.
+ */
+struct StartupStats
+{
+    std::chrono::microseconds directories{0};   // LOGDIR, PICDIR and VIEWDIR, or the archive index
+    std::chrono::microseconds volumes{0};       // loading the referenced volumes and validating the index
+    std::chrono::microseconds views{0};         // decoding the views
+    std::chrono::microseconds total{0};
+};
+
+/**
+ * \class   StartupLoader
+ * \brief   Parses the directory files of a game, and optionally loads all
+ *          the referenced volumes and views on a small thread pool so that
+ *          nothing has to be loaded from disk in the middle of a cycle.
+ *
+ *          If the path is a file instead of a directory, it's opened as a
+ *          game archive and there are no directories or volumes to load.
+ */
+class StartupLoader
+{
+public:
+    StartupLoader(const boost::filesystem::path& path, const StartupOptions& options);
+
+    /**
+     * \brief   Creates the resource index. The referenced volumes are all
+     *          loaded at the same time when prefetching.
+     */
+    ResourceIndex BuildIndex(VolumeLoader& volumes);
+
+    /**
+     * \brief   Decodes all the views, if requested in the options
+     */
+    void Prefetch(const ResourceIndex& resources, ViewLoader& views);
+
+    const StartupStats& GetStats() const noexcept { return stats_; }
+
+private:
+    void Collect(const std::vector<DirectoryEntry>& entries);
+
+    const StartupOptions options_;
+    const std::chrono::steady_clock::time_point start_;
+    std::unique_ptr<ThreadPool> pool_;
+    std::shared_ptr<const GameArchive> archive_;
+    std::vector<DirectoryEntry> logics_;
+    std::vector<DirectoryEntry> pictures_;
+    std::vector<DirectoryEntry> views_;
+    std::bitset<16> referencedVolumes_;
+    StartupStats stats_;
+};
+
+} // namespace agi
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <stddef.h>
+
+namespace agi {
+
+/**
+ * \class   StringArena
+ * \brief   Allocates the decrypted messages of the logics, and the tables
+ *          that points to them, from large blocks. Nothing is released
+ *          until the arena is destroyed, so it must outlive the scripts.
+ */
+class StringArena
+{
+public:
+    enum {
+        kBlockSize = 16 * 1024
+    };
+
+    StringArena() = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    /**
+     * \brief   Allocates uninitialized storage for count characters
+     */
+    char* AllocateString(size_t count) {
+        return static_cast<char*>(Allocate(count, 1));
+    }
+
+    /**
+     * \brief   Allocates storage for count values, which are value initialized
+     */
+    template<class T>
+    T* AllocateArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value,
+            "The arena never calls any destructors.");
+        T* result = static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+        for(size_t i = 0; i < count; ++i) {
+            new (&result[i]) T();
+        }
+        return result;
+    }
+
+    /**
+     * \brief   Returns the number of bytes that has been allocated
+     */
+    size_t GetSize() const noexcept { return size_; }
+
+private:
+    void* Allocate(size_t size, size_t alignment);
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* current_ = nullptr;
+    size_t remaining_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace agi
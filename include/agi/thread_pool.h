@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace agi {
+
+/**
+ * \class   ThreadPool
+ * \brief   A small fixed size pool of worker threads. Every worker has a
+ *          queue of its own, the work is spread over the queues and a
+ *          worker that runs out of work steals from the other queues. A
+ *          worker only sleeps when both come up empty.
+ */
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threads);
+
+    /**
+     * \brief   Finishes all the queued work before joining the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * \brief   Queues a function for execution, the returned future holds
+     *          the result or the exception thrown by the function.
+     */
+    template<class F>
+    auto Submit(F&& function) -> std::future<decltype(function())>
+    {
+        using Result = decltype(function());
+        auto task = std::make_shared<std::packaged_task<Result()> >(
+            std::forward<F>(function));
+        auto result = task->get_future();
+        Push([task]() { (*task)(); });
+        return result;
+    }
+
+    size_t GetNumberOfThreads() const noexcept { return workers_.size(); }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()> > tasks;
+    };
+
+    void Push(std::function<void()> task);
+    std::function<void()> Pop(size_t worker);
+    void Run(size_t worker);
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<Queue> > queues_;
+    std::atomic<size_t> next_{0};       // the queue of the next task
+    std::atomic<size_t> queued_{0};     // tasks in the queues
+    std::atomic<size_t> sleeping_{0};   // workers waiting for work
+    std::mutex mutex_;                  // only taken to sleep and to wake
+    std::condition_variable condition_;
+    bool stop_ = false;
+};
+
+} // namespace agi
@@ -23,4 +23,12 @@ inline uint16_t U16_LE(const uint8_t* data)
     return (static_cast<uint16_t>(data[1]) << 8) | data[0];
 }
 
+inline uint32_t U32_LE(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[3]) << 24) |
+        (static_cast<uint32_t>(data[2]) << 16) |
+        (static_cast<uint32_t>(data[1]) << 8) |
+        data[0];
+}
+
 } // namespace agi
\ No newline at end of file
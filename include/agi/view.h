@@ -1,11 +1,17 @@
 #pragma once
 
+#include <agi/array_view.h>
 #include <agi/source.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <stdint.h>
 #include <vector>
 
 namespace agi {
 
+struct View;
+
 struct Cel
 {
     uint8_t width;
@@ -13,7 +19,16 @@ struct Cel
     uint8_t colorKey    : 4;
     uint8_t mirrored    : 1;
     uint8_t mirrorLoop  : 3;
-    std::vector<uint8_t> pixels;    // the pixel data
+
+    /**
+     * \brief   Returns the width * height pixels of the cel, the cel is
+     *          decoded the first time its pixels are requested.
+     */
+    array_view<uint8_t> GetPixels() const;
+
+    const View* view;               // the view that the cel belongs to
+    uint16_t index;                 // the index of the cel in the view
+    uint32_t offset;                // the offset of the RLE data in the view data
 };
 
 struct Loop
@@ -21,16 +36,77 @@ struct Loop
     std::vector<Cel> cels;   // the cels in the loop
 };
 
+/**
+ * \struct  View
+ * \brief   Only the loop and cel headers are parsed up front, the pixels of
+ *          a cel are decoded when they are first needed. It's safe to
+ *          decode the cels of a view from several threads.
+ */
 struct View
 {
-    std::vector<Loop> loops; // the loops in the view
+    View() = default;
+    View(const View&) = delete;
+    View& operator=(const View&) = delete;
+
+    /**
+     * \brief   Returns the pixels of one of the cels in this view
+     */
+    array_view<uint8_t> GetPixels(const Cel& cel) const;
+
+    /**
+     * \brief   Decodes all the cels that aren't decoded yet
+     */
+    void Decode() const;
+
+    /**
+     * \brief   Sets the data that the cels are decoded from, which must
+     *          outlive the view.
+     */
+    void SetData(array_view<uint8_t> data, size_t celCount);
+
+    /**
+     * \brief   Uses pixels that are already decoded for a cel, the pixels
+     *          must outlive the view.
+     */
+    void SetPixels(const Cel& cel, const uint8_t* pixels);
+
+    /**
+     * \brief   Returns the number of bytes used by the decoded cels, the
+     *          cels that aren't decoded yet are counted as if they were.
+     *          Pixels set with SetPixels aren't owned by the view and not
+     *          counted.
+     */
+    size_t GetPixelSize() const;
+
+    std::vector<Loop> loops;            // the loops in the view
+
+private:
+    array_view<uint8_t> data_;
+    size_t celCount_ = 0;
+    // the pixels of each cel, or nullptr until it's decoded
+    std::unique_ptr<std::atomic<const uint8_t*>[]> pixels_;
+    // guards the decoding, and owns the decoded pixels
+    mutable std::mutex mutex_;
+    mutable std::vector<std::unique_ptr<uint8_t[]> > decoded_;
+    mutable size_t decodedSize_ = 0;
 };
 
+inline array_view<uint8_t> Cel::GetPixels() const
+{
+    return view->GetPixels(*this);
+}
+
 /**
- * \brief   Parses an loop
+ * \brief   Parses the loop and cel headers of a view, the source data must
+ *          outlive the view.
  */
 void ParseView(Source& source, View& result);
 
 void ParseViewResource(Source& source, View& result);
+
+/**
+ * \brief   Returns the number of bytes used by the view
+ */
+size_t GetMemoryUsage(const View& view);
     
 } // namespace agi
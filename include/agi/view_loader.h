@@ -1,34 +1,59 @@
 #pragma once
 
-#include <agi/volume_loader.h>
-#include <agi/directory.h>
+#include <agi/cache.h>
+#include <agi/resource_events.h>
+#include <agi/resource_index.h>
 #include <agi/view.h>
-#include <vector>
-#include <array>
+#include <mutex>
 #include <stdint.h>
 
 namespace agi {
 
 /**
  * \class   ViewLoader
+ * \brief   Loads views, the loader may be used from several threads.
  */
 class ViewLoader
 {
 public:
-    ViewLoader(
-        VolumeLoader& volumes,
-        const boost::filesystem::path& directoryFile);
+    /**
+     * \brief   Constructor, the index must outlive the loader. The views
+     *          are cached until the cache budget (in bytes) is exceeded,
+     *          zero means that the cache is unbounded. The loads are
+     *          reported to the event sink, if there is one.
+     */
+    explicit ViewLoader(
+        const ResourceIndex& resources,
+        size_t cacheBudget = 0,
+        std::shared_ptr<ResourceEventSink> events = nullptr);
 
     /**
-     * \brief   Get a specific script
+     * \brief   Get a specific view, it's loaded if not in the cache
      */
     std::shared_ptr<View> GetView(uint8_t index);
 
+    /**
+     * \brief   Removes the view from the cache, unless it's still used by an
+     *          object. The interpreters that share the loader may be using
+     *          the view, so it's never removed from under them.
+     */
+    void DiscardView(uint8_t index);
+
+    /**
+     * \brief   Evicts the views that are no longer pinned, if the cache
+     *          exceeds the budget. The objects pin their views, so it's
+     *          called when they let go of a view.
+     */
+    void Trim();
+
+    CacheStatistics GetStatistics() const;
+
 private:
-    VolumeLoader& volumes_;
-    std::array<std::shared_ptr<View>, 256> views_;
-    std::vector<DirectoryEntry> entries_;
+    const ResourceIndex& resources_;
+    const std::shared_ptr<ResourceEventSink> events_;
+    const bool reportHits_;                 // asked once, the sink is fixed
+    mutable std::mutex mutex_;
+    ResourceCache<View> views_;
 };
 
 } // namespace agi
-
@@ -1,10 +1,11 @@
 #pragma once
 
 #include <agi/array_view.h>
+#include <agi/mapped_file.h>
 #include <boost/filesystem.hpp>
 #include <stdint.h>
-#include <map>
-#include <vector>
+#include <array>
+#include <memory>
 
 namespace agi {
 
@@ -14,17 +15,22 @@ namespace agi {
 class VolumeLoader
 {
 public:
+    enum {
+        kMaxVolumes = 16
+    };
+
     VolumeLoader(const boost::filesystem::path&);
 
     /**
-     * \brief   Get the data of a specific volume. Once the volume has been
-     *          loaded, it will be kept in memory indefinitly.
+     * \brief   Get the data of a specific volume. The volume is mapped
+     *          read-only the first time it's requested and stays mapped
+     *          for the lifetime of the loader.
      */
     array_view<uint8_t> GetVolume(uint8_t index);
-    
+
 private:
     const boost::filesystem::path path_;
-    std::map<uint8_t, std::vector<uint8_t> > volumes_;
+    std::array<std::unique_ptr<MappedFile>, kMaxVolumes> volumes_;
 };
 
 } // namespace agi
@@ -0,0 +1,167 @@
+#include <agi/archive.h>
+#include <agi/script_loader.h>
+#include <agi/view.h>
+#include <agi/util.h>
+#include <stdexcept>
+#include <cstring>
+
+namespace agi {
+
+namespace {
+
+const size_t kHeaderSize = 16;
+const size_t kIndexEntrySize = 12;
+
+/**
+ * \brief   Reads a u32 at an offset inside the resource, and makes sure
+ *          that it's inside the resource.
+ */
+uint32_t ReadU32(array_view<uint8_t> data, size_t offset)
+{
+    if ((offset > data.size()) || ((data.size() - offset) < 4)) {
+        throw std::runtime_error("Invalid archive resource, offset out of range.");
+    }
+    return U32_LE(&data[offset]);
+}
+
+void CheckRange(array_view<uint8_t> data, size_t offset, size_t size)
+{
+    if ((offset > data.size()) || ((data.size() - offset) < size)) {
+        throw std::runtime_error("Invalid archive resource, data out of range.");
+    }
+}
+
+} // namespace
+
+GameArchive::GameArchive(const boost::filesystem::path& filename) :
+    file_(filename)
+{
+    auto data = file_.GetData();
+    if ((data.size() < kHeaderSize) || (memcmp(data.data(), "AGIA", 4) != 0)) {
+        throw std::runtime_error("Not a game archive, invalid magic number.");
+    }
+    if (U32_LE(&data[4]) != kVersion) {
+        throw std::runtime_error("Unsupported game archive version.");
+    }
+    const size_t count = U32_LE(&data[8]);
+    const size_t indexOffset = U32_LE(&data[12]);
+    if ((indexOffset > data.size()) ||
+        (((data.size() - indexOffset) / kIndexEntrySize) < count))
+    {
+        throw std::runtime_error("Invalid game archive, index does not fit inside the file.");
+    }
+
+    for(size_t i = 0; i < count; ++i) {
+        const uint8_t* entry = &data[indexOffset + (i * kIndexEntrySize)];
+        const uint8_t type = entry[0];
+        const uint8_t number = entry[1];
+        const size_t offset = U32_LE(&entry[4]);
+        const size_t size = U32_LE(&entry[8]);
+        if (type >= resources_.size()) {
+            throw std::runtime_error("Invalid game archive, unknown resource type.");
+        }
+        if ((offset > data.size()) || ((data.size() - offset) < size)) {
+            throw std::runtime_error("Invalid game archive, resource does not fit inside the file.");
+        }
+        // an empty resource would read as missing, and a second entry would
+        // hide the first one
+        if (size == 0) {
+            throw std::runtime_error("Invalid game archive, empty resource.");
+        }
+        if (!resources_[type][number].empty()) {
+            throw std::runtime_error("Invalid game archive, duplicate resource.");
+        }
+        resources_[type][number] = array_view<uint8_t>(data.data() + offset, size);
+    }
+}
+
+bool GameArchive::Contains(ResourceType type, uint8_t index) const noexcept
+{
+    return !resources_[static_cast<size_t>(type)][index].empty();
+}
+
+array_view<uint8_t> GameArchive::GetResource(ResourceType type, uint8_t index) const
+{
+    auto data = resources_[static_cast<size_t>(type)][index];
+    if (data.empty()) {
+        throw std::invalid_argument("Invalid resource index, not part of the archive.");
+    }
+    return data;
+}
+
+std::shared_ptr<Script> GameArchive::LoadScript(uint8_t index, StringArena& strings) const
+{
+    auto data = GetResource(ResourceType::kLogic, index);
+    const size_t codeOffset = ReadU32(data, 0);
+    const size_t codeSize = ReadU32(data, 4);
+    const size_t messageCount = ReadU32(data, 8);
+    CheckRange(data, codeOffset, codeSize);
+    CheckRange(data, 12, messageCount * 4);
+
+    auto result = std::make_shared<Script>();
+    result->code = array_view<uint8_t>(data.data() + codeOffset, codeSize);
+    auto messages = strings.AllocateArray<const char*>(messageCount);
+    for(size_t i = 0; i < messageCount; ++i) {
+        const size_t offset = U32_LE(&data[12 + (i * 4)]);
+        if (offset != 0) {
+            // the message must be terminated inside the resource
+            CheckRange(data, offset, 1);
+            if (!memchr(&data[offset], 0, data.size() - offset)) {
+                throw std::runtime_error("Invalid archive resource, unterminated message.");
+            }
+            messages[i] = reinterpret_cast<const char*>(&data[offset]);
+        }
+    }
+    result->messages = array_view<const char*>(messages, messageCount);
+    return result;
+}
+
+std::shared_ptr<View> GameArchive::LoadView(uint8_t index) const
+{
+    auto data = GetResource(ResourceType::kView, index);
+    const size_t loopCount = ReadU32(data, 0);
+    CheckRange(data, 4, loopCount * 8);
+
+    size_t totalCels = 0;
+    for(size_t i = 0; i < loopCount; ++i) {
+        totalCels += U32_LE(&data[4 + (i * 8)]);
+    }
+    if (totalCels > 0xffff) {
+        throw std::runtime_error("Invalid archive resource, too many cels.");
+    }
+
+    // the cels are already decoded, so they refer directly to the archive
+    auto result = std::make_shared<View>();
+    result->SetData(data, totalCels);
+    result->loops.resize(loopCount);
+    uint16_t celIndex = 0;
+    for(size_t i = 0; i < loopCount; ++i) {
+        auto& loop = result->loops[i];
+        const size_t celCount = U32_LE(&data[4 + (i * 8)]);
+        const size_t celOffset = U32_LE(&data[8 + (i * 8)]);
+        CheckRange(data, celOffset, celCount * 8);
+
+        loop.cels.resize(celCount);
+        for(size_t j = 0; j < celCount; ++j) {
+            const uint8_t* header = &data[celOffset + (j * 8)];
+            auto& cel = loop.cels[j];
+            const uint8_t f = header[2];
+            cel.width = header[0];
+            cel.height = header[1];
+            cel.colorKey = f & 0x0f;
+            cel.mirrored = (f >> 7) & 0x01;
+            cel.mirrorLoop = (f >> 4) & 0x07;
+
+            const size_t pixelOffset = U32_LE(&header[4]);
+            const size_t size = cel.width * cel.height;
+            CheckRange(data, pixelOffset, size);
+            cel.view = result.get();
+            cel.index = celIndex++;
+            cel.offset = static_cast<uint32_t>(pixelOffset);
+            result->SetPixels(cel, data.data() + pixelOffset);
+        }
+    }
+    return result;
+}
+
+} // namespace agi
@@ -0,0 +1,224 @@
+#include <agi/archive.h>
+#include <agi/resource_index.h>
+#include <agi/script_loader.h>
+#include <agi/view.h>
+#include <boost/filesystem/fstream.hpp>
+#include <cstring>
+#include <stdexcept>
+
+namespace agi {
+
+namespace {
+
+/**
+ * \class   Buffer
+ * \brief   Little-endian output buffer for the archive.
+ */
+class Buffer
+{
+public:
+    size_t size() const noexcept { return data_.size(); }
+    const std::vector<uint8_t>& data() const noexcept { return data_; }
+
+    void PutU8(uint8_t value) { data_.push_back(value); }
+
+    void PutU32(uint32_t value)
+    {
+        for(size_t i = 0; i < 4; ++i) {
+            data_.push_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void Put(const uint8_t* data, size_t size)
+    {
+        data_.insert(data_.end(), data, data + size);
+    }
+
+    void PatchU32(size_t offset, uint32_t value)
+    {
+        for(size_t i = 0; i < 4; ++i) {
+            data_[offset + i] = static_cast<uint8_t>(value >> (i * 8));
+        }
+    }
+
+    void Align(size_t alignment)
+    {
+        while(data_.size() % alignment) {
+            data_.push_back(0);
+        }
+    }
+
+private:
+    std::vector<uint8_t> data_;
+};
+
+/**
+ * \brief   The resources are written to buffers of their own, so the
+ *          offsets inside a resource are the offsets in the buffer.
+ */
+void WriteLogic(const Script& script, Buffer& out)
+{
+    const size_t count = script.messages.size();
+    const size_t codeOffset = 12 + (count * 4);
+    out.PutU32(static_cast<uint32_t>(codeOffset));
+    out.PutU32(static_cast<uint32_t>(script.code.size()));
+    out.PutU32(static_cast<uint32_t>(count));
+    const size_t table = out.size();
+    for(size_t i = 0; i < count; ++i) {
+        out.PutU32(0);
+    }
+    out.Put(script.code.data(), script.code.size());
+
+    // the messages are stored decrypted and null-terminated
+    for(size_t i = 0; i < count; ++i) {
+        const char* message = script.messages[i];
+        if (!message) {
+            continue;
+        }
+        out.PatchU32(table + (i * 4), static_cast<uint32_t>(out.size()));
+        out.Put(reinterpret_cast<const uint8_t*>(message), strlen(message) + 1);
+    }
+}
+
+void WriteView(const View& view, Buffer& out)
+{
+    out.PutU32(static_cast<uint32_t>(view.loops.size()));
+    const size_t loopTable = out.size();
+    for(size_t i = 0; i < view.loops.size(); ++i) {
+        out.PutU32(static_cast<uint32_t>(view.loops[i].cels.size()));
+        out.PutU32(0);
+    }
+
+    std::vector<size_t> celHeaders;
+    for(size_t i = 0; i < view.loops.size(); ++i) {
+        out.PatchU32(loopTable + (i * 8) + 4, static_cast<uint32_t>(out.size()));
+        for(auto& cel : view.loops[i].cels) {
+            celHeaders.push_back(out.size());
+            out.PutU8(cel.width);
+            out.PutU8(cel.height);
+            out.PutU8(static_cast<uint8_t>(
+                (cel.mirrored << 7) | (cel.mirrorLoop << 4) | cel.colorKey));
+            out.PutU8(0);
+            out.PutU32(0);
+        }
+    }
+
+    size_t index = 0;
+    for(auto& loop : view.loops) {
+        for(auto& cel : loop.cels) {
+            out.PatchU32(celHeaders[index++] + 4, static_cast<uint32_t>(out.size()));
+            const auto pixels = cel.GetPixels();
+            out.Put(pixels.data(), pixels.size());
+        }
+    }
+}
+
+struct IndexEntry
+{
+    ResourceType type;
+    uint8_t number;
+    size_t offset;
+    size_t size;
+};
+
+/**
+ * \brief   Writes every resource of a type, the writer function gets the
+ *          resource data without the 5 byte header.
+ */
+template<class Writer>
+void WriteResources(
+    const ResourceIndex& resources,
+    ResourceType type,
+    Buffer& out,
+    std::vector<IndexEntry>& index,
+    size_t& written,
+    size_t& skipped,
+    Writer writer)
+{
+    for(size_t i = 0; i < 256; ++i) {
+        const auto& entry = resources.GetEntry(type, static_cast<uint8_t>(i));
+        if (entry.state == ResourceEntry::kMissing) {
+            continue;
+        }
+        // a broken resource doesn't leave anything behind in the archive
+        Buffer resource;
+        try {
+            writer(resources.Get(type, static_cast<uint8_t>(i)), resource);
+        }
+        catch(std::exception&) {
+            ++skipped;
+            continue;
+        }
+        if (resource.size() == 0) {
+            continue;
+        }
+        out.Align(GameArchive::kAlignment);
+        index.push_back({type, static_cast<uint8_t>(i), out.size(), resource.size()});
+        out.Put(resource.data().data(), resource.size());
+        ++written;
+    }
+}
+
+} // namespace
+
+ArchiveSummary WriteGameArchive(
+    const boost::filesystem::path& gameDirectory,
+    const boost::filesystem::path& archiveFile)
+{
+    ArchiveSummary summary;
+    VolumeLoader volumes(gameDirectory);
+    ResourceIndex game(volumes, gameDirectory);
+    Buffer resources;
+    std::vector<IndexEntry> index;
+
+    StringArena strings;
+    WriteResources(game, ResourceType::kLogic,
+        resources, index, summary.logics, summary.skipped,
+        [&strings](array_view<uint8_t> data, Buffer& out) { WriteLogic(*ParseScript(data, strings), out); });
+
+    WriteResources(game, ResourceType::kPicture,
+        resources, index, summary.pictures, summary.skipped,
+        [](array_view<uint8_t> data, Buffer& out) { out.Put(data.data(), data.size()); });
+
+    WriteResources(game, ResourceType::kView,
+        resources, index, summary.views, summary.skipped,
+        [](array_view<uint8_t> data, Buffer& out) {
+            View view;
+            Source source(data.data(), data.size());
+            ParseView(source, view);
+            WriteView(view, out);
+        });
+
+    // the header and the index are followed by the resources
+    Buffer header;
+    const size_t indexOffset = 16;
+    const size_t indexSize = index.size() * 12;
+    const size_t dataOffset =
+        (indexOffset + indexSize + GameArchive::kAlignment - 1) & ~size_t(GameArchive::kAlignment - 1);
+    header.Put(reinterpret_cast<const uint8_t*>("AGIA"), 4);
+    header.PutU32(GameArchive::kVersion);
+    header.PutU32(static_cast<uint32_t>(index.size()));
+    header.PutU32(static_cast<uint32_t>(indexOffset));
+    for(auto& entry : index) {
+        header.PutU8(static_cast<uint8_t>(entry.type));
+        header.PutU8(entry.number);
+        header.PutU8(0);
+        header.PutU8(0);
+        header.PutU32(static_cast<uint32_t>(dataOffset + entry.offset));
+        header.PutU32(static_cast<uint32_t>(entry.size));
+    }
+    header.Align(GameArchive::kAlignment);
+
+    boost::filesystem::ofstream output(archiveFile, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output) {
+        throw std::runtime_error("Failed to open the archive file for writing.");
+    }
+    output.write(reinterpret_cast<const char*>(header.data().data()), header.size());
+    output.write(reinterpret_cast<const char*>(resources.data().data()), resources.size());
+    if (!output) {
+        throw std::runtime_error("Failed to write the archive file.");
+    }
+    return summary;
+}
+
+} // namespace agi
@@ -2,250 +2,307 @@
 
 namespace agi {
 
-namespace {
-
-static const uint8_t ArgumentCount[] = {
-    0, 1, 1, 2, 2, 2, 2, 2,
-    2, 2, 2, 2, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, // call.v
-    1, 1, 0, 1, 1, 0, 1, 1, // var
-    1, 1, 0, 1, 1, 3, 3, 3, // get.posn
-    3, 2, 2, 2, 2, 1, 1, 2, // set.cel
-    2, 2, 2, 2, 2, 2, 2, 2, // set.priority.v
-    1, 2, 1, 1, 1, 1, 1, 1, // set.horizon
-    1, 1, 1, 1, 1, 3, 1, 1, // start.cycling
-    1, 2, 1, 2, 2, 1, 1, 2, // step.size
-    2, 5, 5, 3, 1, 1, 2, 2, // get.dir
-    1, 1, 4, 0, 1, 1, 1, 2, // put
-    2, 2, 1, 2, 0, 1, 1, 3, // display
-    3, 3, 0, 0, 1, 2, 1, 3, // configure.screen
-    0, 0, 2, 5, 2, 1, 2, 0, // prevent.input
-    0, 3, 7, 7, 0, 0, 0, 0, // init.disk
-    0, 1, 3, 0, 0, 1, 1, 0, // show.mem
-    0, 0, 0, 0, 0, 0, 1, 1, // set.game.id
-    1, 0, 0, 3, 3, 0, 3, 4, // print.at
-    4, 1, 5, 2, 1, 2, 0, 1, // enable.item
-    1, 0, 1, 0, 0, 2, 2, 2, // div.n
-    2, 0, 1, 0, 0, 0, 1, 1, // unknown175
-    0, 1, 0, 4, 2, 0        // unknown 181
-};
-
-uint16_t GetU16(ExecState& state)
-{
-    auto& code = state.script->code;
-    if ((state.ip + 2) < code.size()) {
-        const uint8_t low = code[state.ip++]; // LSB
-        const uint8_t high = code[state.ip++]; // MSB
-        return (static_cast<uint16_t>(high) << 8) | low;
-    }
-    else {
-        throw std::runtime_error(
-            "Failed to read U16 since it's outside the valid script range.");
-    }               
-}
+// GCC and Clang supports taking the address of a label, which lets every
+// instruction jump directly to the next one instead of going through a
+// shared switch.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(AGI_NO_COMPUTED_GOTO)
+#define AGI_COMPUTED_GOTO 1
+#endif
 
-size_t GetNumberOfArguments(uint8_t cmd)
-{
-    assert(cmd < (sizeof(ArgumentCount) / sizeof(ArgumentCount[0])));
-    return ArgumentCount[cmd];
-}
+// the commands of the categories that the logics execute the most, every one
+// of them has a handler of its own which the handler table calls directly
+#define AGI_ARITHMETIC_COMMANDS(X)                                          \
+    X(kIncrement) X(kDecrement) X(kAssignN) X(kAssignV) X(kAddN)            \
+    X(kAddV) X(kSubN) X(kSubV) X(kLIndirectV) X(kRIndirect)                 \
+    X(kLIndirectN) X(kSet) X(kReset) X(kToggle) X(kSetV) X(kResetV)         \
+    X(kToggleV) X(kRandom)
+
+#define AGI_PROGRAM_CONTROL_COMMANDS(X)                                     \
+    X(kReturn) X(kCall) X(kCallV) X(kNewRoom) X(kNewRoomV)
 
-} // namespace
+#define AGI_OBJECT_DESCRIPTION_COMMANDS(X)                                  \
+    X(kAnimateObj) X(kUnanimateAll) X(kDraw) X(kErase) X(kPosition)         \
+    X(kPositionV) X(kGetPosN) X(kSetView) X(kSetViewV) X(kSetLoop)          \
+    X(kSetLoopV) X(kFixLoop) X(kReleaseLoop) X(kSetCel) X(kSetCelV)         \
+    X(kLastCel) X(kCurrentCel) X(kCurrentLoop) X(kCurrentView)              \
+    X(kNumberOfLoops) X(kSetPriority) X(kSetPriorityV)                      \
+    X(kReleasePriority) X(kGetPriority) X(kStopCycling) X(kStartCycling)    \
+    X(kNormalCycle) X(kEndOfLoop) X(kReverseCycle) X(kReverseLoop)          \
+    X(kCycleTime)
+
+#define AGI_OBJECT_MOTION_COMMANDS(X)                                       \
+    X(kReposition) X(kStopUpdate) X(kStartUpdate) X(kForceUpdate)           \
+    X(kIgnoreHorizon) X(kObserveHorizon) X(kSetHorizon) X(kObjectOnWater)   \
+    X(kObjectOnLand) X(kObjectOnAnything) X(kIgnoreObjects)                 \
+    X(kObserveObjects) X(kDistance) X(kStopMotion) X(kStartMotion)          \
+    X(kStepSize) X(kStepTime) X(kMoveObj) X(kIgnoreBlocks)                  \
+    X(kProgramControl) X(kObserveBlocks) X(kPlayerControl)
+
+// defines the handler of a single command
+#define AGI_COMMAND(name)                                                   \
+    template<>                                                              \
+    void Interpreter::Command<ActionCommand::name>(uint8_t, const uint8_t* arguments)
+
+// a case of a category switch, which calls the handler of the command
+#define AGI_COMMAND_CASE(name)                                              \
+    case ActionCommand::name:                                               \
+        Command<ActionCommand::name>(cmd, arguments);                       \
+        break;
 
 boost::optional<UserActionRequest> Interpreter::Cycle()
 {
-    // get the script that we are currently executing
-    boost::optional<UserActionRequest> uar;
-    while(!scriptStack_.empty()) {
-        auto& state = scriptStack_.back(); // get current script
-        auto& code = state.script->code;
-        assert(code.size() > 0);
-        if (state.ip >= code.size()) {
-            // reached the end of the script
-            return boost::optional<UserActionRequest>();
-        }
+    const auto& handlers = GetCommandHandlers();
+    NativeContext context(*this);
+    ExecState* state = nullptr;
+    const Instruction* instruction = nullptr;
 
-        // read the instruction byte
-        const uint8_t cmd = code[state.ip++];
-        if (cmd == 0xff) {
-            state.ip += LogicalAnd(state) ? 2 : GetU16(state);
-        }
-        else if (cmd == 0xfe) {
-            int16_t distance = GetU16(state);
-            state.ip += distance;
-        }
-        else {
-            const size_t argc = GetNumberOfArguments(cmd);
-            if ((state.ip + argc) > code.size()) {
-                throw std::runtime_error(
-                    "Arguments to script command is outside of the script buffer.");
-            }
-            // the arguments follow the instruction
-            const uint8_t* argv = argc ? &code[state.ip] : 0;
-            // increment the instruction pointer
-            state.ip += argc;
-            // execute the command
-            switch(GetCommandType(cmd)) {
-            case CommandType::kArithmetic:
-                ArithmeticCommand(cmd, argv);
-                break;
-            case CommandType::kResourceManagement:
-                ResourceManagementCommand(cmd, argv);
-                break;
-            case CommandType::kProgramControl:
-                ProgramControlCommand(cmd, argv);
-                break;
-            case CommandType::kObjectDescription:
-                ObjectDescriptionCommand(cmd, argv);
-                break;
-            case CommandType::kObjectMotion:
-                ObjectMotionCommand(cmd, argv);
-                break;
-            case CommandType::kInventoryItem:
-                InventoryItemCommand(cmd, argv);
-                break;
-            case CommandType::kPictureManagement:
-                PictureManagementCommand(cmd, argv);
-                break;
-            case CommandType::kSoundManagement:
-                SoundManagementCommand(cmd, argv);
-                break;
-            case CommandType::kTextManagement:
-                TextManagementCommand(cmd, argv);
-                break;
-            case CommandType::kStringManagement:
-                uar = StringManagementCommand(cmd, argv);
-                break;
-            case CommandType::kInitialization:
-                InitializationCommand(cmd, argv);
-                break;
-            case CommandType::kMenuManagement:
-                MenuManagementCommand(cmd, argv);
-                break;
-            case CommandType::kOther:
-                MiscCommand(cmd, argv);
-                break;
-            }
-        }
-        if (uar) {
-            return uar;
+#ifdef AGI_ENABLE_PROFILER
+    // the logic and offset are saved before the instruction is executed,
+    // since the instruction may change the script stack
+    Profiler::Clock::time_point profileStart;
+    uint8_t profileLogic = 0;
+    uint32_t profileOffset = 0;
+#define AGI_PROFILE_BEGIN(index)                                            \
+    if (profiler_) {                                                        \
+        profileLogic = state->logic;                                        \
+        profileOffset = state->script->offsets[index];                      \
+        profileStart = Profiler::Clock::now();                              \
+    }
+#define AGI_PROFILE_END(command)                                            \
+    if (profiler_) {                                                        \
+        const auto elapsed = Profiler::Clock::now() - profileStart;         \
+        profiler_->AddInstruction(profileLogic, profileOffset, command, elapsed); \
+        if (command < 0xfd) {                                               \
+            profiler_->AddCommand(command, elapsed);                        \
+        }                                                                   \
+    }
+#else
+#define AGI_PROFILE_BEGIN(index)
+#define AGI_PROFILE_END(command)
+#endif
+
+    // fetches the next instruction of the current script, the cycle ends
+    // when the script stack is empty or when the end of a script is reached
+#define AGI_FETCH()                                                         \
+    if (scriptStack_.empty()) {                                             \
+        return boost::optional<UserActionRequest>();                        \
+    }                                                                       \
+    state = &scriptStack_.back();                                           \
+    if (state->ip >= state->script->instructions.size()) {                  \
+        return boost::optional<UserActionRequest>();                        \
+    }                                                                       \
+    if (state->script->native) {                                            \
+        goto native;                                                        \
+    }                                                                       \
+    instruction = &state->script->instructions[state->ip++]
+
+#if AGI_COMPUTED_GOTO
+    // indexed by Instruction::Kind, every instruction jumps directly to the
+    // next one
+    static void* const kinds[] = { &&command, &&branch, &&jump, &&invalid };
+#define AGI_DISPATCH() AGI_FETCH(); goto *kinds[instruction->kind]
+    AGI_DISPATCH();
+#else
+#define AGI_DISPATCH() goto next
+next:
+    AGI_FETCH();
+    switch(instruction->kind) {
+    case Instruction::kCommand:
+        goto command;
+    case Instruction::kIf:
+        goto branch;
+    case Instruction::kGoto:
+        goto jump;
+    default:
+        goto invalid;
+    }
+#endif
+
+command:
+    AGI_PROFILE_BEGIN(state->ip - 1);
+    (this->*handlers[instruction->command])(instruction->command, instruction->arguments);
+    AGI_PROFILE_END(instruction->command);
+    if (request_) {
+        goto request;
+    }
+    AGI_DISPATCH();
+
+branch:
+    AGI_PROFILE_BEGIN(state->ip - 1);
+    {
+        const auto& conditions = state->script->conditions;
+        if (!EvaluateConditions(conditions.data() + instruction->condition, instruction->conditionCount)) {
+            state->ip = instruction->target;
         }
     }
-    return uar;
+    AGI_PROFILE_END(0xff);
+    AGI_DISPATCH();
+
+jump:
+    AGI_PROFILE_BEGIN(state->ip - 1);
+    state->ip = instruction->target;
+    AGI_PROFILE_END(0xfe);
+    AGI_DISPATCH();
+
+invalid:
+    throw std::runtime_error("Invalid instruction in script.");
+
+native:
+    // the translated logic runs until it ends or the script stack changes
+    AGI_PROFILE_BEGIN(state->ip);
+    state->script->native(context, state->ip);
+    AGI_PROFILE_END(Profiler::kNative);
+    if (request_) {
+        goto request;
+    }
+    AGI_DISPATCH();
+
+request:
+    {
+        // the command needs user action before the cycle can continue
+        auto request = std::move(request_);
+        request_ = boost::none;
+        return request;
+    }
+
+#undef AGI_PROFILE_END
+#undef AGI_PROFILE_BEGIN
+#undef AGI_DISPATCH
+#undef AGI_FETCH
+}
+
+void Interpreter::InvalidCommand(uint8_t, const uint8_t*)
+{
+    throw std::runtime_error("Invalid command in script.");
 }
 
 /*****************************************************************************/
 /*                              Arithmetic commands                          */
 /*****************************************************************************/
+AGI_COMMAND(kIncrement)
+{
+    // Var(n) = Var(n) + 1
+    auto& var = variables_[arguments[0]];
+    if (var < 255) {
+        ++var;
+    }
+}
+
+AGI_COMMAND(kDecrement)
+{
+    // Var(n) = Var(n) - 1
+    auto& var = variables_[arguments[0]];
+    if (var > 0) {
+        --var;
+    }
+}
+
+AGI_COMMAND(kAssignN)
+{
+    // Var(n) = m
+    SetVariable(arguments[0], arguments[1]);
+}
+
+AGI_COMMAND(kAssignV)
+{
+    // Var(n) = Var(m)
+    variables_[arguments[0]] = variables_[arguments[1]];
+}
+
+AGI_COMMAND(kAddN)
+{
+    // Var(n) = Var(n) + m
+    auto& var = variables_[arguments[0]];
+    var = static_cast<uint8_t>(std::min(255u, static_cast<unsigned>(var) + arguments[1]));
+}
+
+AGI_COMMAND(kAddV)
+{
+    // Var(n) = Var(n) + Var(m)
+    auto& varN = variables_[arguments[0]];
+    auto varM = variables_[arguments[1]];
+    varN = static_cast<uint8_t>(std::min(255u, static_cast<unsigned>(varN) + static_cast<unsigned>(varM)));
+}
+
+AGI_COMMAND(kSubN)
+{
+    // Var(n) = Var(n) - m
+    auto& var = variables_[arguments[0]];
+    auto m = arguments[1];
+    var = (var < m) ? 0 : (var - m);
+}
+
+AGI_COMMAND(kSubV)
+{
+    // Var(n) = Var(n) - Var(m)
+    auto& varN = variables_[arguments[0]];
+    auto varM = variables_[arguments[1]];
+    varN = (varN < varM) ? 0 : (varN - varM);
+}
+
+AGI_COMMAND(kLIndirectV)
+{
+    // Var(Var(n)) = Var(m)
+    auto varN = variables_[arguments[0]];
+    variables_[varN] = variables_[arguments[1]];
+}
+
+AGI_COMMAND(kRIndirect)
+{
+    // Var(n) = Var(Var(m))
+    auto varM = variables_[arguments[1]]; // Var(m)
+    variables_[arguments[0]] = variables_[varM]; // Var(Var(m))
+}
+
+AGI_COMMAND(kLIndirectN)
+{
+    // Var(Var(n)) = m
+    auto varN = variables_[arguments[0]];
+    variables_[varN] = arguments[1];
+}
+
+AGI_COMMAND(kSet)
+{
+    flags_.set(arguments[0]);
+}
+
+AGI_COMMAND(kReset)
+{
+    flags_.reset(arguments[0]);
+}
+
+AGI_COMMAND(kToggle)
+{
+    flags_.flip(arguments[0]);
+}
+
+AGI_COMMAND(kSetV)
+{
+    flags_.set(variables_[arguments[0]]);
+}
+
+AGI_COMMAND(kResetV)
+{
+    flags_.reset(variables_[arguments[0]]);
+}
+
+AGI_COMMAND(kToggleV)
+{
+    flags_.flip(variables_[arguments[0]]);
+}
+
+AGI_COMMAND(kRandom)
+{
+    // random(n, m, k)
+    SetVariable(arguments[2], (random_() % arguments[1]) + arguments[0]);
+}
+
 void Interpreter::ArithmeticCommand(
     uint8_t cmd,
     const uint8_t* arguments)
 {
     switch(static_cast<ActionCommand>(cmd)) {
-    case ActionCommand::kIncrement:
-        {
-            // Var(n) = Var(n) + 1
-            auto& var = variables_[arguments[0]];
-            if (var < 255) {
-                ++var;
-            }
-            break;
-        }
-    case ActionCommand::kDecrement:
-        {
-            // Var(n) = Var(n) - 1
-            auto& var = variables_[arguments[0]];
-            if (var > 0) {
-                --var;
-            }
-            break;   
-        }
-    case ActionCommand::kAssignN:
-        {
-            // Var(n) = m
-            SetVariable(arguments[0], arguments[1]);
-            break;
-        }
-    case ActionCommand::kAssignV:
-        {
-            // Var(n) = Var(m)
-            variables_[arguments[0]] = variables_[arguments[1]];
-            break;
-        }
-    case ActionCommand::kAddN:
-        {
-            // Var(n) = Var(n) + m
-            auto& var = variables_[arguments[0]];
-            var = static_cast<uint8_t>(std::min(255u, static_cast<unsigned>(var) + arguments[1]));
-            break;
-        }
-    case ActionCommand::kAddV:
-        {
-            // Var(n) = Var(n) + Var(m)
-            auto& varN = variables_[arguments[0]];
-            auto varM = variables_[arguments[1]];
-            varN = static_cast<uint8_t>(std::min(255u, static_cast<unsigned>(varN) + static_cast<unsigned>(varM)));
-            break;
-        }
-    case ActionCommand::kSubN:
-        {
-            // Var(n) = Var(n) - m
-            auto& var = variables_[arguments[0]];
-            auto m = arguments[1];
-            var = (var < m) ? 0 : (var - m);
-            break;   
-        }
-    case ActionCommand::kSubV:
-        {
-            // Var(n) = Var(n) - Var(m)
-            auto& varN = variables_[arguments[0]];
-            auto varM = variables_[arguments[1]];
-            varN = (varN < varM) ? 0 : (varN - varM); 
-            break;
-        }
-    case ActionCommand::kLIndirectV:
-        {
-            // Var(Var(n)) = Var(m)
-            auto varN = variables_[arguments[0]];
-            variables_[varN] = variables_[arguments[1]];
-            break;
-        }
-    case ActionCommand::kRIndirect:
-        {
-            // Var(n) = Var(Var(m))
-            auto varM = variables_[arguments[1]]; // Var(m)
-            variables_[arguments[0]] = variables_[varM]; // Var(Var(m))
-            break;
-        }
-    case ActionCommand::kLIndirectN:
-        {
-            // Var(Var(n)) = m
-            auto varN = variables_[arguments[0]];
-            variables_[varN] = arguments[1];
-            break;
-        }
-    case ActionCommand::kSet:
-        flags_.set(arguments[0]);
-        break;
-    case ActionCommand::kReset:
-        flags_.reset(arguments[0]);
-        break;
-    case ActionCommand::kToggle:
-        flags_.flip(arguments[0]);
-        break;
-    case ActionCommand::kSetV:
-        flags_.set(variables_[arguments[0]]);
-        break;
-    case ActionCommand::kResetV:
-        flags_.reset(variables_[arguments[0]]);
-        break;
-    case ActionCommand::kToggleV:
-        flags_.flip(variables_[arguments[0]]);
-        break;
-    case ActionCommand::kRandom:
-        // random(n, m, k)
-        SetVariable(arguments[2], (rand() % arguments[1]) + arguments[0]);
-        break;
+    AGI_ARITHMETIC_COMMANDS(AGI_COMMAND_CASE)
     default:
         assert(false);
     }
@@ -266,16 +323,23 @@ void Interpreter::ResourceManagementCommand(
         scripts_.LoadScript(variables_[arguments[0]]);
         break;
     case ActionCommand::kLoadPic:
+        loadedPictures_[variables_[arguments[0]]] = pictures_.LoadPicture(variables_[arguments[0]]);
         break;
     case ActionCommand::kDiscardPic:
+        loadedPictures_[variables_[arguments[0]]].reset();
+        pictures_.Trim();
         break;
     case ActionCommand::kLoadView:
+        views_.GetView(arguments[0]);
         break;
     case ActionCommand::kLoadViewV:
+        views_.GetView(variables_[arguments[0]]);
         break;
     case ActionCommand::kDiscardView:
+        views_.DiscardView(arguments[0]);
         break;
     case ActionCommand::kDiscardViewV:
+        views_.DiscardView(variables_[arguments[0]]);
         break;
     case ActionCommand::kLoadSound:
         break;
@@ -288,24 +352,37 @@ void Interpreter::ResourceManagementCommand(
 /*                                  Program control                          */
 /*****************************************************************************/
 
+AGI_COMMAND(kReturn)
+{
+    scriptStack_.pop_back();
+}
+
+AGI_COMMAND(kCall)
+{
+    Call(arguments[0]);
+}
+
+AGI_COMMAND(kCallV)
+{
+    Call(variables_[arguments[0]]);
+}
+
+AGI_COMMAND(kNewRoom)
+{
+    NewRoom(arguments[0]);
+}
+
+AGI_COMMAND(kNewRoomV)
+{
+    NewRoom(variables_[arguments[0]]);
+}
+
 void Interpreter::ProgramControlCommand(
     uint8_t cmd,
     const uint8_t* arguments)
 {
     switch(static_cast<ActionCommand>(cmd)) {
-    case ActionCommand::kReturn:
-        scriptStack_.pop_back();
-        break;
-    case ActionCommand::kCall:
-        Call(arguments[0]);
-        break;
-    case ActionCommand::kCallV:
-        Call(variables_[arguments[0]]);
-        break;
-    case ActionCommand::kNewRoom:
-        return NewRoom(arguments[0]);
-    case ActionCommand::kNewRoomV:
-        return NewRoom(variables_[arguments[0]]);
+    AGI_PROGRAM_CONTROL_COMMANDS(AGI_COMMAND_CASE)
     default:
         assert(false);
     }
@@ -314,104 +391,167 @@ void Interpreter::ProgramControlCommand(
 /*****************************************************************************/
 /*                                Object description                         */
 /*****************************************************************************/
+AGI_COMMAND(kAnimateObj)
+{
+    AnimateObject(arguments[0]);
+}
+
+AGI_COMMAND(kUnanimateAll)
+{
+    UnanimateAll();
+}
+
+AGI_COMMAND(kDraw)
+{
+    DrawObject(arguments[0]);
+}
+
+AGI_COMMAND(kErase)
+{
+    EraseObject(arguments[0]);
+}
+
+AGI_COMMAND(kPosition)
+{
+    SetObjectPosition(arguments[0], arguments[1], arguments[2]);
+}
+
+AGI_COMMAND(kPositionV)
+{
+    SetObjectPosition(arguments[0], variables_[arguments[1]], variables_[arguments[2]]);
+}
+
+AGI_COMMAND(kGetPosN)
+{
+    GetObjectPosition(arguments[1], variables_[arguments[1]], variables_[arguments[2]]);
+}
+
+AGI_COMMAND(kSetView)
+{
+    SetObjectView(arguments[0], arguments[1]);
+}
+
+AGI_COMMAND(kSetViewV)
+{
+    SetObjectView(arguments[0], variables_[arguments[1]]);
+}
+
+AGI_COMMAND(kSetLoop)
+{
+    GetObject(arguments[0]).animation.SetLoop(arguments[1]);
+}
+
+AGI_COMMAND(kSetLoopV)
+{
+    GetObject(arguments[0]).animation.SetLoop(variables_[arguments[1]]);
+}
+
+AGI_COMMAND(kFixLoop)
+{
+    GetObject(arguments[0]).flags |= FIXED_LOOP_FLAG;
+}
+
+AGI_COMMAND(kReleaseLoop)
+{
+    GetObject(arguments[0]).flags &= ~FIXED_LOOP_FLAG;
+}
+
+AGI_COMMAND(kSetCel)
+{
+    GetObject(arguments[0]).animation.SetCel(arguments[1]);
+}
+
+AGI_COMMAND(kSetCelV)
+{
+    GetObject(arguments[0]).animation.SetCel(variables_[arguments[1]]);
+}
+
+AGI_COMMAND(kLastCel)
+{
+    variables_[arguments[1]] = GetObject(arguments[0]).animation.LastCel();
+}
+
+AGI_COMMAND(kCurrentCel)
+{
+    variables_[arguments[1]] = GetObject(arguments[0]).animation.celIndex;
+}
+
+AGI_COMMAND(kCurrentLoop)
+{
+    variables_[arguments[1]] = GetObject(arguments[0]).animation.loopIndex;
+}
+
+AGI_COMMAND(kCurrentView)
+{
+    variables_[arguments[1]] = GetObject(arguments[0]).animation.viewIndex;
+}
+
+AGI_COMMAND(kNumberOfLoops)
+{
+    variables_[arguments[1]] = GetObject(arguments[0]).animation.numberOfLoops;
+}
+
+AGI_COMMAND(kSetPriority)
+{
+    GetObject(arguments[0]).animation.priority = arguments[1];
+}
+
+AGI_COMMAND(kSetPriorityV)
+{
+    GetObject(arguments[0]).animation.priority = variables_[arguments[1]];
+}
+
+AGI_COMMAND(kReleasePriority)
+{
+    GetObject(arguments[0]).flags &= ~FIXED_PRIORITY_FLAG;
+}
+
+AGI_COMMAND(kGetPriority)
+{
+    variables_[arguments[1]] = GetObject(arguments[0]).GetPriority();
+}
+
+AGI_COMMAND(kStopCycling)
+{
+    GetObject(arguments[0]).animation.StopCycling();
+}
+
+AGI_COMMAND(kStartCycling)
+{
+    GetObject(arguments[0]).animation.StartCycling();
+}
+
+AGI_COMMAND(kNormalCycle)
+{
+    GetObject(arguments[0]).animation.NormalCycle();
+}
+
+AGI_COMMAND(kEndOfLoop)
+{
+    GetObject(arguments[0]).animation.EndOfLoop(arguments[1]);
+}
+
+AGI_COMMAND(kReverseCycle)
+{
+    GetObject(arguments[0]).animation.ReverseCycle();
+}
+
+AGI_COMMAND(kReverseLoop)
+{
+    GetObject(arguments[0]).animation.ReverseLoop(arguments[1]);
+}
+
+AGI_COMMAND(kCycleTime)
+{
+    GetObject(arguments[0]).animation.cycleTime = arguments[1];
+}
+
 void Interpreter::ObjectDescriptionCommand(
     uint8_t cmd,
     const uint8_t* arguments)
 {
     switch(static_cast<ActionCommand>(cmd)) {
-    case ActionCommand::kAnimateObj:
-        AnimateObject(arguments[0]);
-        break;
-    case ActionCommand::kUnanimateAll:
-        UnanimateAll();
-        break;
-    case ActionCommand::kDraw:
-        DrawObject(arguments[0]);
-        break;   
-    case ActionCommand::kErase:
-        EraseObject(arguments[0]);
-        break;
-    case ActionCommand::kPosition:
-        SetObjectPosition(arguments[0], arguments[1], arguments[2]);
-        break;
-    case ActionCommand::kPositionV:
-        SetObjectPosition(arguments[0], variables_[arguments[1]], variables_[arguments[2]]);
-        break;
-    case ActionCommand::kGetPosN:
-        GetObjectPosition(arguments[1], variables_[arguments[1]], variables_[arguments[2]]);
-        break;
-    case ActionCommand::kSetView:
-        SetObjectView(arguments[0], arguments[1]);
-        break;   
-    case ActionCommand::kSetViewV:
-        SetObjectView(arguments[0], variables_[arguments[1]]);
-        break;
-    case ActionCommand::kSetLoop:
-        GetObject(arguments[0]).animation.SetLoop(arguments[1]);
-        break;
-    case ActionCommand::kSetLoopV:
-        GetObject(arguments[0]).animation.SetLoop(variables_[arguments[1]]);
-        break;
-    case ActionCommand::kFixLoop:
-        GetObject(arguments[0]).flags |= FIXED_LOOP_FLAG;
-        break;
-    case ActionCommand::kReleaseLoop:
-        GetObject(arguments[0]).flags &= ~FIXED_LOOP_FLAG;
-        break;
-    case ActionCommand::kSetCel:
-        GetObject(arguments[0]).animation.SetCel(arguments[1]);
-        break;
-    case ActionCommand::kSetCelV:
-        GetObject(arguments[0]).animation.SetCel(variables_[arguments[1]]);
-        break;
-    case ActionCommand::kLastCel:
-        variables_[arguments[1]] = GetObject(arguments[0]).animation.LastCel();
-        break;
-    case ActionCommand::kCurrentCel:
-        variables_[arguments[1]] = GetObject(arguments[0]).animation.celIndex;
-        break;
-    case ActionCommand::kCurrentLoop:
-        variables_[arguments[1]] = GetObject(arguments[0]).animation.loopIndex;
-        break;
-    case ActionCommand::kCurrentView:
-        variables_[arguments[1]] = GetObject(arguments[0]).animation.viewIndex;
-        break;
-    case ActionCommand::kNumberOfLoops:
-        variables_[arguments[1]] = GetObject(arguments[0]).animation.numberOfLoops;
-        break;
-    case ActionCommand::kSetPriority:
-        GetObject(arguments[0]).animation.priority = arguments[1];
-        break;
-    case ActionCommand::kSetPriorityV:
-        GetObject(arguments[0]).animation.priority = variables_[arguments[1]];
-        break;
-    case ActionCommand::kReleasePriority:
-        GetObject(arguments[0]).flags &= ~FIXED_PRIORITY_FLAG;
-        break;
-    case ActionCommand::kGetPriority:
-        variables_[arguments[1]] = GetObject(arguments[0]).GetPriority();
-        break;
-    case ActionCommand::kStopCycling:
-        GetObject(arguments[0]).animation.StopCycling();
-        break;
-    case ActionCommand::kStartCycling:
-        GetObject(arguments[0]).animation.StartCycling();
-        break;
-    case ActionCommand::kNormalCycle:
-        GetObject(arguments[0]).animation.NormalCycle();
-        break;
-    case ActionCommand::kEndOfLoop:
-        GetObject(arguments[0]).animation.EndOfLoop(arguments[1]);
-        break;
-    case ActionCommand::kReverseCycle:
-        GetObject(arguments[0]).animation.ReverseCycle();
-        break;
-    case ActionCommand::kReverseLoop:
-        GetObject(arguments[0]).animation.ReverseLoop(arguments[1]);
-        break;
-    case ActionCommand::kCycleTime:
-        GetObject(arguments[0]).animation.cycleTime = arguments[1];
-        break;
+    AGI_OBJECT_DESCRIPTION_COMMANDS(AGI_COMMAND_CASE)
     default:
         assert(false);
     }
@@ -419,77 +559,122 @@ void Interpreter::ObjectDescriptionCommand(
 /*****************************************************************************/
 /*                                  Object motion                            */
 /*****************************************************************************/
+AGI_COMMAND(kReposition)
+{
+    Reposition(arguments[0], variables_[arguments[1]], variables_[arguments[2]]);
+}
+
+AGI_COMMAND(kStopUpdate)
+{
+    StopUpdate(arguments[0]);
+}
+
+AGI_COMMAND(kStartUpdate)
+{
+    StartUpdate(arguments[0]);
+}
+
+AGI_COMMAND(kForceUpdate)
+{
+    ForceUpdate(arguments[0]);
+}
+
+AGI_COMMAND(kIgnoreHorizon)
+{
+    GetObject(arguments[0]).flags &= ~OBSERVE_HORIZON_FLAG;
+}
+
+AGI_COMMAND(kObserveHorizon)
+{
+    GetObject(arguments[0]).flags &= OBSERVE_HORIZON_FLAG;
+}
+
+AGI_COMMAND(kSetHorizon)
+{
+    horizon_ = arguments[0];
+}
+
+AGI_COMMAND(kObjectOnWater)
+{
+    GetObject(arguments[0]).movement.allowedSurface = SurfaceType::kWater;
+}
+
+AGI_COMMAND(kObjectOnLand)
+{
+    GetObject(arguments[0]).movement.allowedSurface = SurfaceType::kLand;
+}
+
+AGI_COMMAND(kObjectOnAnything)
+{
+    GetObject(arguments[0]).movement.allowedSurface = SurfaceType::kAny;
+}
+
+AGI_COMMAND(kIgnoreObjects)
+{
+    GetObject(arguments[0]).flags &= ~OBSERVE_OBJECTS_FLAG;
+}
+
+AGI_COMMAND(kObserveObjects)
+{
+    GetObject(arguments[0]).flags |= OBSERVE_OBJECTS_FLAG;
+}
+
+AGI_COMMAND(kDistance)
+{
+    variables_[arguments[2]] = Distance(arguments[0], arguments[1]);
+}
+
+AGI_COMMAND(kStopMotion)
+{
+    StopMotion(arguments[0]);
+}
+
+AGI_COMMAND(kStartMotion)
+{
+    StartMotion(arguments[0]);
+}
+
+AGI_COMMAND(kStepSize)
+{
+    GetObject(arguments[0]).movement.stepSize = variables_[arguments[1]];
+}
+
+AGI_COMMAND(kStepTime)
+{
+    GetObject(arguments[0]).movement.stepTime = variables_[arguments[1]];
+}
+
+AGI_COMMAND(kMoveObj)
+{
+    MoveObject(arguments[0], arguments[1], arguments[2], arguments[3], arguments[4]);
+}
+
+AGI_COMMAND(kIgnoreBlocks)
+{
+    //assert(false);
+}
+
+AGI_COMMAND(kProgramControl)
+{
+    programControl_ = true;
+}
+
+AGI_COMMAND(kObserveBlocks)
+{
+    //assert(false);
+}
+
+AGI_COMMAND(kPlayerControl)
+{
+    programControl_ = false;
+}
+
 void Interpreter::ObjectMotionCommand(
     uint8_t cmd,
     const uint8_t* arguments)
 {
     switch(static_cast<ActionCommand>(cmd)) {
-    case ActionCommand::kReposition:
-        Reposition(arguments[0], variables_[arguments[1]], variables_[arguments[2]]);
-        break;
-    case ActionCommand::kStopUpdate:
-        StopUpdate(arguments[0]);
-        break;
-    case ActionCommand::kStartUpdate:
-        StartUpdate(arguments[0]);
-        break;
-    case ActionCommand::kForceUpdate:
-        ForceUpdate(arguments[0]);
-        break;
-    case ActionCommand::kIgnoreHorizon:
-        GetObject(arguments[0]).flags &= ~OBSERVE_HORIZON_FLAG;
-        break;
-    case ActionCommand::kObserveHorizon:
-        GetObject(arguments[0]).flags &= OBSERVE_HORIZON_FLAG;
-        break;
-    case ActionCommand::kSetHorizon:
-        horizon_ = arguments[0];
-        break;
-    case ActionCommand::kObjectOnWater:
-        GetObject(arguments[0]).movement.allowedSurface = SurfaceType::kWater;
-        break;
-    case ActionCommand::kObjectOnLand:
-        GetObject(arguments[0]).movement.allowedSurface = SurfaceType::kLand;
-        break;
-    case ActionCommand::kObjectOnAnything:
-        GetObject(arguments[0]).movement.allowedSurface = SurfaceType::kAny;
-        break;
-    case ActionCommand::kIgnoreObjects:
-        GetObject(arguments[0]).flags &= ~OBSERVE_OBJECTS_FLAG;
-        break;
-    case ActionCommand::kObserveObjects:
-        GetObject(arguments[0]).flags |= OBSERVE_OBJECTS_FLAG;
-        break;
-    case ActionCommand::kDistance:
-        variables_[arguments[2]] = Distance(arguments[0], arguments[1]);
-        break;
-    case ActionCommand::kStopMotion:
-        StopMotion(arguments[0]);
-        break;
-    case ActionCommand::kStartMotion:
-        StartMotion(arguments[0]);
-        break;
-    case ActionCommand::kStepSize:
-        GetObject(arguments[0]).movement.stepSize = variables_[arguments[1]];
-        break;
-    case ActionCommand::kStepTime:
-        GetObject(arguments[0]).movement.stepTime = variables_[arguments[1]];
-        break;
-    case ActionCommand::kMoveObj:
-        MoveObject(arguments[0], arguments[1], arguments[2], arguments[3], arguments[4]);
-        break;
-    case ActionCommand::kIgnoreBlocks:
-        //assert(false);
-        break;
-    case ActionCommand::kProgramControl:
-        programControl_ = true;
-        break;
-    case ActionCommand::kObserveBlocks:
-        //assert(false);
-        break;
-    case ActionCommand::kPlayerControl:
-        programControl_ = false;
-        break;
+    AGI_OBJECT_MOTION_COMMANDS(AGI_COMMAND_CASE)
     default:
         assert(false);
     }
@@ -578,6 +763,15 @@ void Interpreter::MiscCommand(
     case ActionCommand::kOpenDialogue:
     case ActionCommand::kCloseDialogue:
         break;
+    case ActionCommand::kSaveGame:
+        SaveGame();
+        break;
+    case ActionCommand::kRestoreGame:
+        RestoreGame();
+        break;
+    case ActionCommand::kRestartGame:
+        RestartGame();
+        break;
     default:
         assert(false);
     }
@@ -586,7 +780,7 @@ void Interpreter::MiscCommand(
 /*****************************************************************************/
 /*                                   String management                       */
 /*****************************************************************************/
-boost::optional<UserActionRequest> Interpreter::StringManagementCommand(
+void Interpreter::StringManagementCommand(
     uint8_t cmd,
     const uint8_t* arguments)
 {
@@ -606,7 +800,6 @@ boost::optional<UserActionRequest> Interpreter::StringManagementCommand(
     default:
         assert(false);
     }
-    return boost::optional<UserActionRequest>();
 }
 
 /*****************************************************************************/
@@ -679,4 +872,143 @@ void Interpreter::InventoryItemCommand(
     }
 }
 
+
+/*****************************************************************************/
+/*                                       Dispatch                            */
+/*****************************************************************************/
+const std::array<Interpreter::CommandHandler, 256>& Interpreter::GetCommandHandlers()
+{
+    static const std::array<CommandHandler, 256> handlers = [] {
+        std::array<CommandHandler, 256> result;
+        for(size_t i = 0; i < result.size(); ++i) {
+            const uint8_t cmd = static_cast<uint8_t>(i);
+            if (!IsCommandValid(cmd)) {
+                // never executed, since the translation rejects the command
+                result[i] = &Interpreter::InvalidCommand;
+                continue;
+            }
+            switch(GetCommandType(cmd)) {
+            case CommandType::kArithmetic:
+                result[i] = &Interpreter::ArithmeticCommand;
+                break;
+            case CommandType::kResourceManagement:
+                result[i] = &Interpreter::ResourceManagementCommand;
+                break;
+            case CommandType::kProgramControl:
+                result[i] = &Interpreter::ProgramControlCommand;
+                break;
+            case CommandType::kObjectDescription:
+                result[i] = &Interpreter::ObjectDescriptionCommand;
+                break;
+            case CommandType::kObjectMotion:
+                result[i] = &Interpreter::ObjectMotionCommand;
+                break;
+            case CommandType::kInventoryItem:
+                result[i] = &Interpreter::InventoryItemCommand;
+                break;
+            case CommandType::kPictureManagement:
+                result[i] = &Interpreter::PictureManagementCommand;
+                break;
+            case CommandType::kSoundManagement:
+                result[i] = &Interpreter::SoundManagementCommand;
+                break;
+            case CommandType::kTextManagement:
+                result[i] = &Interpreter::TextManagementCommand;
+                break;
+            case CommandType::kStringManagement:
+                result[i] = &Interpreter::StringManagementCommand;
+                break;
+            case CommandType::kInitialization:
+                result[i] = &Interpreter::InitializationCommand;
+                break;
+            case CommandType::kMenuManagement:
+                result[i] = &Interpreter::MenuManagementCommand;
+                break;
+            case CommandType::kOther:
+                result[i] = &Interpreter::MiscCommand;
+                break;
+            }
+        }
+        // the commands with a handler of their own skip the switch of their
+        // category, the rest of the category still goes through it
+#define AGI_COMMAND_HANDLER(name)                                           \
+        result[static_cast<size_t>(ActionCommand::name)] = &Interpreter::Command<ActionCommand::name>;
+        AGI_ARITHMETIC_COMMANDS(AGI_COMMAND_HANDLER)
+        AGI_PROGRAM_CONTROL_COMMANDS(AGI_COMMAND_HANDLER)
+        AGI_OBJECT_DESCRIPTION_COMMANDS(AGI_COMMAND_HANDLER)
+        AGI_OBJECT_MOTION_COMMANDS(AGI_COMMAND_HANDLER)
+#undef AGI_COMMAND_HANDLER
+        return result;
+    }();
+    return handlers;
+}
+
+void Interpreter::ExecuteCommand(uint8_t cmd, const uint8_t* argv)
+{
+    switch(GetCommandType(cmd)) {
+    case CommandType::kArithmetic:
+        ArithmeticCommand(cmd, argv);
+        break;
+    case CommandType::kResourceManagement:
+        ResourceManagementCommand(cmd, argv);
+        break;
+    case CommandType::kProgramControl:
+        ProgramControlCommand(cmd, argv);
+        break;
+    case CommandType::kObjectDescription:
+        ObjectDescriptionCommand(cmd, argv);
+        break;
+    case CommandType::kObjectMotion:
+        ObjectMotionCommand(cmd, argv);
+        break;
+    case CommandType::kInventoryItem:
+        InventoryItemCommand(cmd, argv);
+        break;
+    case CommandType::kPictureManagement:
+        PictureManagementCommand(cmd, argv);
+        break;
+    case CommandType::kSoundManagement:
+        SoundManagementCommand(cmd, argv);
+        break;
+    case CommandType::kTextManagement:
+        TextManagementCommand(cmd, argv);
+        break;
+    case CommandType::kStringManagement:
+        StringManagementCommand(cmd, argv);
+        break;
+    case CommandType::kInitialization:
+        InitializationCommand(cmd, argv);
+        break;
+    case CommandType::kMenuManagement:
+        MenuManagementCommand(cmd, argv);
+        break;
+    case CommandType::kOther:
+        MiscCommand(cmd, argv);
+        break;
+    }
+}
+
+void Interpreter::ExecuteCommands(const std::vector<Instruction>& commands, CommandDispatch dispatch)
+{
+    // one loop per dispatch, so neither pays for choosing between them
+    if (dispatch == CommandDispatch::kTable) {
+        const auto& handlers = GetCommandHandlers();
+        for(auto& instruction : commands) {
+            (this->*handlers[instruction.command])(instruction.command, instruction.arguments);
+        }
+    }
+    else {
+        for(auto& instruction : commands) {
+            ExecuteCommand(instruction.command, instruction.arguments);
+        }
+    }
+}
+
+#undef AGI_COMMAND_CASE
+#undef AGI_COMMAND
+#undef AGI_OBJECT_MOTION_COMMANDS
+#undef AGI_OBJECT_DESCRIPTION_COMMANDS
+#undef AGI_PROGRAM_CONTROL_COMMANDS
+#undef AGI_ARITHMETIC_COMMANDS
+
 } // namespace agi
@@ -1,5 +1,6 @@
 #include <agi/commands.h>
 #include <iostream>
+#include <assert.h>
 
 namespace agi {
 
@@ -178,8 +179,77 @@ const char* cmds[] = {
     "close.window"
 };
 
+static const uint8_t ArgumentCount[] = {
+    0, 1, 1, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, // call.v
+    1, 1, 0, 1, 1, 0, 1, 1, // var
+    1, 1, 0, 1, 1, 3, 3, 3, // get.posn
+    3, 2, 2, 2, 2, 1, 1, 2, // set.cel
+    2, 2, 2, 2, 2, 2, 2, 2, // set.priority.v
+    1, 2, 1, 1, 1, 1, 1, 1, // set.horizon
+    1, 1, 1, 1, 1, 3, 1, 1, // start.cycling
+    1, 2, 1, 2, 2, 1, 1, 2, // step.size
+    2, 5, 5, 3, 1, 1, 2, 2, // get.dir
+    1, 1, 4, 0, 1, 1, 1, 2, // put
+    2, 2, 1, 2, 0, 1, 1, 3, // display
+    3, 3, 0, 0, 1, 2, 1, 3, // configure.screen
+    0, 0, 2, 5, 2, 1, 2, 0, // prevent.input
+    0, 3, 7, 7, 0, 0, 0, 0, // init.disk
+    0, 1, 3, 0, 0, 1, 1, 0, // show.mem
+    0, 0, 0, 0, 0, 0, 1, 1, // set.game.id
+    1, 0, 0, 3, 3, 0, 3, 4, // print.at
+    4, 1, 5, 2, 1, 2, 0, 1, // enable.item
+    1, 0, 1, 0, 0, 2, 2, 2, // div.n
+    2, 0, 1, 0, 0, 0, 1, 1, // unknown175
+    0, 1, 0, 4, 2, 0        // unknown 181
+};
+
+const char* conditions[] = {
+    "false",
+    "equaln",
+    "equalv",
+    "lessn",
+    "lessv",
+    "greatern",
+    "greaterv",
+    "isset",
+    "issetv",
+    "has",
+    "obj.in.room",
+    "posn",
+    "controller",
+    "have.key",
+    "said",
+    "compare.strings",
+    "obj.in.box",
+    "center.posn",
+    "right.posn"
+};
+
+static const uint8_t ConditionArguments[] = {
+    0, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 5, 1, 0, 0, 2, 5, 5, 5
+};
+
 } // namespace
 
+size_t GetNumberOfArguments(uint8_t cmd)
+{
+    assert(cmd < (sizeof(ArgumentCount) / sizeof(ArgumentCount[0])));
+    return ArgumentCount[cmd];
+}
+
+bool IsConditionValid(uint8_t condition)
+{
+    return condition < (sizeof(ConditionArguments) / sizeof(ConditionArguments[0]));
+}
+
+size_t GetNumberOfConditionArguments(uint8_t condition)
+{
+    assert(IsConditionValid(condition));
+    return ConditionArguments[condition];
+}
+
 const char* GetCommandName(uint8_t cmd)
 {
     if (cmd < (sizeof(cmds)/sizeof(cmds[0]))) {
@@ -196,4 +266,12 @@ const char* GetCommandName(uint8_t cmd)
     }
 }
 
+const char* GetConditionName(uint8_t condition)
+{
+    if (condition < (sizeof(conditions)/sizeof(conditions[0]))) {
+        return conditions[condition];
+    }
+    return "unknown";
+}
+
 } // namespace agi
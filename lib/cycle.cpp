@@ -38,9 +38,21 @@ boost::optional<UserActionRequest> Interpreter::ResumeCycle()
     // update the clock variables
     UpdateClock();
     auto uar = Cycle();
-    if (!uar) {
+    if (abandonCycle_) {
+        // the game was restored or restarted during the cycle
+        abandonCycle_ = false;
+    }
+    else if (!uar) {
         // no new user action request, so finish the current cycle
-        FinishCycle();
+        if (timeFinishCycle_) {
+            const auto start = std::chrono::steady_clock::now();
+            FinishCycle();
+            finishCycleTime_ = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+        }
+        else {
+            FinishCycle();
+        }
     }
     return uar;
 }
@@ -61,15 +73,39 @@ void Interpreter::FinishCycle()
     SetFlag(Flag::kRestoreGameExecuted, false);
 
     // PaintScene
-    PaintScene();
+    if (paintScene_) {
+        PaintScene();
+    }
 
     // now update any controlled objects
     UpdateControlledObjects();
 }
 
+size_t Interpreter::RunCycles(size_t count)
+{
+    size_t completed = 0;
+    try {
+        for(; completed < count; ++completed) {
+            paintScene_ = (completed + 1) == count;
+            if (StartCycle()) {
+                // the cycle is waiting for user action
+                break;
+            }
+        }
+    }
+    catch(...) {
+        paintScene_ = true;
+        throw;
+    }
+    paintScene_ = true;
+    return completed;
+}
+
 void Interpreter::PaintScene()
 {
-    framebuffer_ = pictureBuffer_;
+    // only the rows that changed since the last paint are copied, and they
+    // are passed on as dirty rows to whoever presents the framebuffer
+    framebuffer_.CopyRows(pictureBuffer_, pictureBuffer_.TakeDirtyRows());
 }
 
 } // namespace agi
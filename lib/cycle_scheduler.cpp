@@ -0,0 +1,42 @@
+#include <agi/cycle_scheduler.h>
+#include <algorithm>
+
+namespace agi {
+
+CycleScheduler::CycleScheduler(size_t maxCatchUp) :
+    maxCatchUp_(std::max<size_t>(maxCatchUp, 1))
+{
+    // empty
+}
+
+size_t CycleScheduler::GetDueCycles(Clock::time_point now, Clock::duration period)
+{
+    if (!started_ || (period <= Clock::duration::zero())) {
+        // the first cycle, or the cycles aren't throttled
+        Reset(now);
+        next_ += period;
+        return 1;
+    }
+    if (now < next_) {
+        return 0;
+    }
+    size_t due = static_cast<size_t>((now - next_) / period) + 1;
+    if (due > maxCatchUp_) {
+        // too far behind, running all of them would only make it worse
+        skipped_ += due - maxCatchUp_;
+        due = maxCatchUp_;
+        next_ = now + period;
+    }
+    else {
+        next_ += due * period;
+    }
+    return due;
+}
+
+void CycleScheduler::Reset(Clock::time_point now)
+{
+    started_ = true;
+    next_ = now;
+}
+
+} // namespace agi
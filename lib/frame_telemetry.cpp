@@ -0,0 +1,154 @@
+#include <agi/frame_telemetry.h>
+#include <algorithm>
+#include <assert.h>
+
+namespace agi {
+
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while(result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+uint32_t GetPercentile(const std::vector<uint32_t>& sorted, size_t percent)
+{
+    assert(!sorted.empty());
+    const size_t index = ((sorted.size() - 1) * percent) / 100;
+    return sorted[index];
+}
+
+} // namespace
+
+const char* GetFramePhaseName(FramePhase phase)
+{
+    switch(phase) {
+    case FramePhase::kCycle:
+        return "cycle";
+    case FramePhase::kFinishCycle:
+        return "finish";
+    case FramePhase::kConvert:
+        return "convert";
+    case FramePhase::kUpload:
+        return "upload";
+    case FramePhase::kPresent:
+        return "present";
+    default:
+        return "total";
+    }
+}
+
+uint32_t FrameTimings::GetTotal() const
+{
+    uint32_t result = 0;
+    for(auto time : phases) {
+        result += time;
+    }
+    return result;
+}
+
+FrameTelemetry::FrameTelemetry(size_t capacity) :
+    mask_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 1)) - 1),
+    slots_(new Slot[mask_ + 1]),
+    written_(0)
+{
+    for(size_t i = 0; i <= mask_; ++i) {
+        slots_[i].frame.store(0, std::memory_order_relaxed);
+    }
+}
+
+void FrameTelemetry::Push(const FrameTimings& timings)
+{
+    const uint64_t frame = written_.load(std::memory_order_relaxed);
+    auto& slot = slots_[frame & mask_];
+    // readers skip the slot while it's written
+    slot.frame.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for(size_t i = 0; i < kFramePhases; ++i) {
+        slot.phases[i].store(timings.phases[i], std::memory_order_relaxed);
+    }
+    slot.frame.store(frame + 1, std::memory_order_release);
+    written_.store(frame + 1, std::memory_order_release);
+}
+
+std::vector<FrameTimings> FrameTelemetry::GetFrames() const
+{
+    const uint64_t written = written_.load(std::memory_order_acquire);
+    const uint64_t count = std::min<uint64_t>(written, mask_ + 1);
+    std::vector<FrameTimings> result;
+    result.reserve(count);
+    for(uint64_t frame = written - count; frame < written; ++frame) {
+        const auto& slot = slots_[frame & mask_];
+        if (slot.frame.load(std::memory_order_acquire) != (frame + 1)) {
+            continue;
+        }
+        FrameTimings timings;
+        for(size_t i = 0; i < kFramePhases; ++i) {
+            timings.phases[i] = slot.phases[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.frame.load(std::memory_order_relaxed) != (frame + 1)) {
+            // overwritten while it was read
+            continue;
+        }
+        result.push_back(timings);
+    }
+    return result;
+}
+
+FrameStatistics GetFrameStatistics(const std::vector<FrameTimings>& frames, FramePhase phase)
+{
+    FrameStatistics result;
+    if (frames.empty()) {
+        return result;
+    }
+    std::vector<uint32_t> times;
+    times.reserve(frames.size());
+    for(auto& frame : frames) {
+        times.push_back((phase == FramePhase::kMax) ? frame.GetTotal() : frame[phase]);
+    }
+    std::sort(times.begin(), times.end());
+    result.p50 = GetPercentile(times, 50);
+    result.p90 = GetPercentile(times, 90);
+    result.p99 = GetPercentile(times, 99);
+    result.max = times.back();
+    return result;
+}
+
+std::vector<size_t> GetFrameHistogram(
+    const std::vector<FrameTimings>& frames,
+    uint32_t width,
+    size_t buckets)
+{
+    assert(width > 0);
+    std::vector<size_t> result(buckets);
+    if (buckets) {
+        for(auto& frame : frames) {
+            const size_t bucket = std::min<size_t>(frame.GetTotal() / width, buckets - 1);
+            ++result[bucket];
+        }
+    }
+    return result;
+}
+
+void WriteFrameCsv(std::ostream& out, const std::vector<FrameTimings>& frames)
+{
+    out << "frame";
+    for(size_t i = 0; i < kFramePhases; ++i) {
+        out << ',' << GetFramePhaseName(static_cast<FramePhase>(i)) << "_us";
+    }
+    out << ",total_us\n";
+    for(size_t frame = 0; frame < frames.size(); ++frame) {
+        out << frame;
+        for(auto time : frames[frame].phases) {
+            out << ',' << time;
+        }
+        out << ',' << frames[frame].GetTotal() << '\n';
+    }
+}
+
+} // namespace agi
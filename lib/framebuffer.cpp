@@ -1,6 +1,5 @@
 #include <agi/framebuffer.h>
-#include <queue>
-#include <cmath>
+#include <cstdlib>
 #include <algorithm>
 #include <assert.h>
 #include <iostream>
@@ -17,9 +16,48 @@ void Framebuffer::Clear()
 {
     pictureDraw_ = 1;
     priorityDraw_ = 1;
+    // a picture drawn after a clear never depends on an earlier picture
+    pictureColor_ = kWhite;
+    priorityColor_ = kRed;
 
     std::fill(picture_.begin(), picture_.end(), kWhite);
     std::fill(priority_.begin(), priority_.end(), kRed);
+    std::fill(text_.begin(), text_.end(), 0);
+    std::fill(textRows_.begin(), textRows_.end(), false);
+    dirty_.Add(0, kHeight);
+}
+
+void Framebuffer::SetTextBuffer(const uint8_t* text)
+{
+    std::copy(text, text + text_.size(), text_.begin());
+    for(size_t y = 0; y < kHeight; ++y) {
+        const auto row = text_.begin() + (y * kTextPitch);
+        textRows_[y] = std::any_of(row, row + kTextPitch, [](uint8_t bits) { return bits != 0; });
+    }
+    dirty_.Add(0, kHeight);
+}
+
+void Framebuffer::CopyRows(const Framebuffer& source, const DirtyRows& rows)
+{
+    // the rows are compared before they're copied, so a scene that is
+    // redrawn the same way every cycle doesn't leave any rows dirty
+    const size_t bottom = std::min<size_t>(rows.bottom, kHeight);
+    for(size_t y = rows.top; y < bottom; ++y) {
+        const size_t offset = y * kWidth;
+        const size_t textOffset = y * kTextPitch;
+        if ((textRows_[y] == source.textRows_[y]) &&
+            !memcmp(&picture_[offset], &source.picture_[offset], kWidth) &&
+            !memcmp(&priority_[offset], &source.priority_[offset], kWidth) &&
+            !memcmp(&text_[textOffset], &source.text_[textOffset], kTextPitch))
+        {
+            continue;
+        }
+        memcpy(&picture_[offset], &source.picture_[offset], kWidth);
+        memcpy(&priority_[offset], &source.priority_[offset], kWidth);
+        memcpy(&text_[textOffset], &source.text_[textOffset], kTextPitch);
+        textRows_[y] = source.textRows_[y];
+        dirty_.Add(y, y + 1);
+    }
 }
 
 void Framebuffer::SetPictureColor(uint8_t color)
@@ -143,120 +181,191 @@ void Framebuffer::RelativeLine(const Points& points)
     }
 }
 
-namespace {
-
-int round(float aNumber, float dirn)
+void Framebuffer::Fill(uint8_t x, uint8_t y)
 {
-    if (dirn < 0) {
-        return ((aNumber - floor(aNumber) <= 0.501)? floor(aNumber) : ceil(aNumber));
+    if (!pictureDraw_ || (pictureColor_ == kWhite)) {
+        // only white picture pixels are filled, and only with another color
+        return;
+    }
+    if (priorityDraw_) {
+        FillSpans<true>(x, y);
     }
     else {
-        return ((aNumber - floor(aNumber) < 0.499)? floor(aNumber) : ceil(aNumber));
+        FillSpans<false>(x, y);
     }
 }
 
+template<bool PriorityDraw>
+void Framebuffer::FillSpans(uint8_t x, uint8_t y)
+{
+    if ((x >= kWidth) || (y >= kHeight)) {
+        return;
+    }
+    // a pixel is pushed at most once from the row above and once from the
+    // row below, since the spans of a row never overlap. The stack is
+    // allocated once per thread, it's too large for the call stack of the
+    // workers that render pictures.
+    static thread_local std::vector<uint16_t> stack((kWidth * kHeight * 2) + 1);
+    size_t size = 0;
+    stack[size++] = static_cast<uint16_t>((y * kWidth) + x);
+
+    // pushes the start of every fillable run within [left, right] of a row
+    auto pushRuns = [&](int left, int right, int row) {
+        for(int i = left; i <= right; ++i) {
+            if (IsWhite(i, row) && ((i == left) || !IsWhite(i - 1, row))) {
+                assert(size < stack.size());
+                stack[size++] = static_cast<uint16_t>((row * kWidth) + i);
+            }
+        }
+    };
+
+    while(size) {
+        const uint16_t seed = stack[--size];
+        const int row = seed / kWidth;
+        int left = seed % kWidth;
+        if (!IsWhite(left, row)) {
+            // already filled through another seed
+            continue;
+        }
+        int right = left;
+        while((left > 0) && IsWhite(left - 1, row)) {
+            --left;
+        }
+        while((right < (kWidth - 1)) && IsWhite(right + 1, row)) {
+            ++right;
+        }
+        DrawHorizontalSpan<true, PriorityDraw>(left, right, row);
 
-} // namespace
+        // the fill spreads upwards from any row, but never downwards from
+        // the last row of the play area
+        if (row > 0) {
+            pushRuns(left, right, row - 1);
+        }
+        if (row < kFillBottom) {
+            pushRuns(left, right, row + 1);
+        }
+    }
+}
 
-bool Framebuffer::CanFill(uint8_t x, uint8_t y)
+void Framebuffer::DrawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2)
 {
-    if (!pictureDraw_ && priorityDraw_) {
-        // neither drawing is enabled
-        return false;
+    if (pictureDraw_ && priorityDraw_) {
+        DrawLine<true, true>(x1, y1, x2, y2);
     }
-    if (pictureColor_ == 15) {
-        // can't draw white
-        return false;
+    else if (pictureDraw_) {
+        DrawLine<true, false>(x1, y1, x2, y2);
     }
-    if (!priorityDraw_) {
-        // priority draw is not enabled, can only fill white areas
-        return GetPicturePixel(x, y) == 15;
+    else if (priorityDraw_) {
+        DrawLine<false, true>(x1, y1, x2, y2);
     }
-    if (priorityDraw_ && !pictureDraw_) {
-        // priority draw is enabled, but not picture drawing, Only
-        // fill read areas
-        return GetPriorityPixel(x, y) == 4;
-    }
-    return GetPicturePixel(x, y) == 15;
 }
 
-void Framebuffer::Fill(uint8_t x, uint8_t y)
+template<bool PictureDraw, bool PriorityDraw>
+void Framebuffer::DrawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2)
 {
-    std::queue<uint8_t> queue;
-    queue.push(x);
-    queue.push(y);
-
-    while(!queue.empty()) {
-        // get coordinates
-        x = queue.front(); queue.pop();
-        y = queue.front(); queue.pop();
-
-        if (CanFill(x, y)) {
-            SetPixel(x, y);
+    if (y1 == y2) {
+        DrawHorizontalSpan<PictureDraw, PriorityDraw>(std::min(x1, x2), std::max(x1, x2), y1);
+        return;
+    }
+    if (x1 == x2) {
+        DrawVerticalSpan<PictureDraw, PriorityDraw>(x1, std::min(y1, y2), std::max(y1, y2));
+        return;
+    }
 
-            if ((x > 0) && CanFill(x - 1, y)) {
-                queue.push(x - 1);
-                queue.push(y);
-            }
-            if ((x < 159) && CanFill(x + 1, y)) {
-                queue.push(x + 1);
-                queue.push(y);
-            }
-            if ((y > 0) && CanFill(x, y - 1)) {
-                queue.push(x);
-                queue.push(y - 1);
+    // integer stepping along the major axis, the minor axis is rounded
+    // half away from the start point just like the original interpreter
+    const int deltaX = std::abs(x2 - x1);
+    const int deltaY = std::abs(y2 - y1);
+    const int stepX = (x2 < x1) ? -1 : 1;
+    const int stepY = (y2 < y1) ? -1 : 1;
+    int x = x1;
+    int y = y1;
+    if (deltaX >= deltaY) {
+        // the line is a series of horizontal runs
+        int error = deltaX / 2;
+        int run = x;
+        for(int i = 0; i < deltaX; ++i) {
+            x += stepX;
+            error += deltaY;
+            if (error >= deltaX) {
+                error -= deltaX;
+                const int last = x - stepX;
+                DrawHorizontalSpan<PictureDraw, PriorityDraw>(std::min(run, last), std::max(run, last), y);
+                y += stepY;
+                run = x;
             }
-            if ((y < 167) && CanFill(x, y + 1)) {
-                queue.push(x);
-                queue.push(y + 1);
+        }
+        DrawHorizontalSpan<PictureDraw, PriorityDraw>(std::min(run, x), std::max(run, x), y);
+    }
+    else {
+        // the line is a series of vertical runs
+        int error = deltaY / 2;
+        int run = y;
+        for(int i = 0; i < deltaY; ++i) {
+            y += stepY;
+            error += deltaX;
+            if (error >= deltaY) {
+                error -= deltaY;
+                const int last = y - stepY;
+                DrawVerticalSpan<PictureDraw, PriorityDraw>(x, std::min(run, last), std::max(run, last));
+                x += stepX;
+                run = y;
             }
         }
+        DrawVerticalSpan<PictureDraw, PriorityDraw>(x, std::min(run, y), std::max(run, y));
     }
 }
 
-void Framebuffer::DrawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2)
+template<bool PictureDraw, bool PriorityDraw>
+void Framebuffer::DrawHorizontalSpan(uint8_t x1, uint8_t x2, uint8_t y)
 {
-    if (x1 == x2) {
-        // vertical line
-        const uint8_t starty = std::min(y1, y2);
-        const uint8_t endy = std::max(y1, y2);
-        for(uint8_t y = starty; y <= endy; ++y) {
-            SetPixel(x1, y);
-        }
+    assert(x1 <= x2);
+    if ((y >= kHeight) || (x1 >= kWidth)) {
+        return;
     }
-    else if (y1 == y2) {
-        // horizontal line
-        const uint8_t startx = std::min(x1, x2);
-        const uint8_t endx = std::max(x1, x2);
-        for(uint8_t x = startx; x <= endx; ++x) {
-            SetPixel(x, y1);
+    const size_t count = std::min<size_t>(x2, kWidth - 1) - x1 + 1;
+    if (PictureDraw) {
+        memset(&picture_[(y * kWidth) + x1], pictureColor_, count);
+        if (textRows_[y]) {
+            ClearText(x1, x1 + count - 1, y);
         }
     }
-    else {
-        int height = (y2 - y1);
-        int width = (x2 - x1);
-        float addX = static_cast<float>(width) / static_cast<float>(abs(height));
-        float addY = static_cast<float>(height) / static_cast<float>(abs(width));
-
-        if (abs(width) > abs(height)) {
-            float y = y1;
-            addX = width / abs(width);
-            for(float x = x1; x != x2; x+= addX) {
-                SetPixel(round(x, addX), round(y, addY));
-                y += addY;
+    if (PriorityDraw) {
+        memset(&priority_[(y * kWidth) + x1], priorityColor_, count);
+    }
+    dirty_.Add(y, y + 1);
+}
+
+template<bool PictureDraw, bool PriorityDraw>
+void Framebuffer::DrawVerticalSpan(uint8_t x, uint8_t y1, uint8_t y2)
+{
+    assert(y1 <= y2);
+    if ((x >= kWidth) || (y1 >= kHeight)) {
+        return;
+    }
+    const size_t end = std::min<size_t>(y2, kHeight - 1);
+    // the span is walked with row pointers, with the rows indexed from the
+    // arrays GCC 12 at -O2 rewrites the addresses into a form that it then
+    // takes for a null access and drops the whole span
+    uint8_t* picture = &picture_[(y1 * kWidth) + x];
+    uint8_t* priority = &priority_[(y1 * kWidth) + x];
+    for(size_t y = y1;; ++y) {
+        if (PictureDraw) {
+            *picture = pictureColor_;
+            if (textRows_[y]) {
+                ClearText(x, x, y);
             }
-            SetPixel(x2, y2);
         }
-        else {
-            float x = x1;
-            addY = height / abs(height);
-            for(float y = y1; y != y2; y += addY) {
-                SetPixel(round(x, addX), round(y, addY));
-                x += addX;
-            }
-            SetPixel(x2, y2);
+        if (PriorityDraw) {
+            *priority = priorityColor_;
         }
+        if (y == end) {
+            break;
+        }
+        picture += kWidth;
+        priority += kWidth;
     }
+    dirty_.Add(y1, end + 1);
 }
 
 namespace {
@@ -532,46 +641,40 @@ static const uint8_t fontData_PCBIOS[] = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 
-static const uint8_t PixelMask[] = {
-    0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01
-};
-
 } // namespace
 
 void Framebuffer::Display(uint8_t row, uint8_t col, const char* text)
 {
-    size_t pixelX = col * 8;
-    size_t pixelY = row * 8;
-
-    const char* currentp = text;
-    while(*currentp) {
-        const uint8_t ch = *currentp;
+    const size_t pixelY = row * 8;
+    if (pixelY >= kHeight) {
+        return;
+    }
+    // the characters are aligned to the bytes of the text rows
+    for(size_t column = col; *text && (column < kTextPitch); ++column, ++text) {
+        const uint8_t ch = *text;
         // each character is 8x8 with one bits per pixel, which means that
         // each character occupies 8 bytes
-        size_t index = ch * 8;
+        const uint8_t* glyph = &fontData_PCBIOS[ch * 8];
         for(size_t y = 0; y < 8; ++y) {
-            // get the mask for this row
-            uint8_t mask = fontData_PCBIOS[index++];
-            for(size_t x = 0; x < 8; x++) {
-                if (mask & PixelMask[x]) {
-                    SetHiDPIPixel(pixelX + x, pixelY + y, 15);
-                }
-            }
+            text_[((pixelY + y) * kTextPitch) + column] |= glyph[y];
+            textRows_[pixelY + y] = true;
         }
-        // continue with next character
-        pixelX += 8;
-        ++currentp;
+        dirty_.Add(pixelY, pixelY + 8);
     }
 }
 
 void Framebuffer::ClearLines(uint8_t start, uint8_t stop, uint8_t color)
 {
     const size_t startPixelRow = start * 8;
-    const size_t endPixelRow = (stop * 8) + 8;
+    const size_t endPixelRow = std::min<size_t>((stop * 8) + 8, kHeight);
 
     for(size_t y = startPixelRow; y < endPixelRow; ++y) {
-        const size_t offset = y * kPixelPitch;
-        memset(&picture_[offset], color, 320);
+        memset(&picture_[y * kWidth], color, kWidth);
+        memset(&text_[y * kTextPitch], 0, kTextPitch);
+        textRows_[y] = false;
+    }
+    if (startPixelRow < endPixelRow) {
+        dirty_.Add(startPixelRow, endPixelRow);
     }
 }
 
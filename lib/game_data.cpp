@@ -0,0 +1,28 @@
+#include <agi/game_data.h>
+
+namespace agi {
+
+GameData::GameData(
+    const boost::filesystem::path& path,
+    const GameOptions& options) :
+    GameData(path, options, StartupLoader(path, options.startup))
+{
+    // empty
+}
+
+GameData::GameData(
+    const boost::filesystem::path& path,
+    const GameOptions& options,
+    StartupLoader&& loader) :
+    volumes_(path),
+    resources_(loader.BuildIndex(volumes_)),
+    scripts_(resources_, options.events, options.native),
+    pictures_(resources_, options.pictureCacheBudget, options.events),
+    views_(resources_, options.viewCacheBudget, options.events)
+{
+    // decode the views up front if requested
+    loader.Prefetch(resources_, views_);
+    startupStats_ = loader.GetStats();
+}
+
+} // namespace agi
@@ -16,10 +16,10 @@ bool Interpreter::UserPressedKey()
 
 void Interpreter::PollInput()
 {
-    std::bitset<SDL_NUM_SCANCODES> pressedKeys;
+    std::bitset<static_cast<size_t>(Key::kMax)> pressedKeys;
     // process all the key events
-    for(auto& keySym : keys_) {
-        pressedKeys.set(keySym.scancode);
+    for(auto& key : keys_) {
+        pressedKeys.set(static_cast<size_t>(key.key));
     }
     keys_.clear();
 
@@ -30,19 +30,19 @@ void Interpreter::PollInput()
     else {
         auto& ego = GetObject(0).movement;
         // poll input
-        if (pressedKeys.test(SDL_SCANCODE_LEFT)) {
+        if (pressedKeys.test(static_cast<size_t>(Key::kLeft))) {
             ego.direction =
                 (ego.direction == Direction::kWest) ? Direction::kStationary : Direction::kWest;
         }
-        else if (pressedKeys.test(SDL_SCANCODE_UP)) {
+        else if (pressedKeys.test(static_cast<size_t>(Key::kUp))) {
             ego.direction =
                 (ego.direction == Direction::kNorth) ? Direction::kStationary : Direction::kNorth;   
         }
-        else if (pressedKeys.test(SDL_SCANCODE_RIGHT)) {
+        else if (pressedKeys.test(static_cast<size_t>(Key::kRight))) {
             ego.direction =
                 (ego.direction == Direction::kEast) ? Direction::kStationary : Direction::kEast;
         }
-        else if (pressedKeys.test(SDL_SCANCODE_DOWN)) {
+        else if (pressedKeys.test(static_cast<size_t>(Key::kDown))) {
             ego.direction =
                 (ego.direction == Direction::kSouth) ? Direction::kStationary : Direction::kSouth;
         }
@@ -0,0 +1,177 @@
+#include <agi/instruction.h>
+#include <agi/util.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace agi {
+
+namespace {
+
+/**
+ * \brief   Compiles the test commands of an if, returns false if the
+ *          conditions can't be decoded.
+ */
+bool CompileConditions(array_view<uint8_t> code, size_t& offset, std::vector<Condition>& conditions)
+{
+    bool negate = false;
+    size_t group = 0;       // the kOr condition of the current group
+    bool inGroup = false;
+    while(offset < code.size()) {
+        const uint8_t b = code[offset++];
+        if (b == 0xff) {
+            // end of the conditions
+            return !inGroup;
+        }
+        else if (b == 0xfd) {
+            // not
+            negate = !negate;
+        }
+        else if (b == 0xfc) {
+            if (inGroup) {
+                // end of the or group
+                inGroup = false;
+            }
+            else {
+                // start of an or group, the negation applies to the group
+                inGroup = true;
+                group = conditions.size();
+                conditions.push_back(Condition{Condition::kOr, negate, 0});
+                negate = false;
+            }
+        }
+        else {
+            Condition condition = {b, negate};
+            negate = false;
+            if (b == 0x0e) {
+                // said(), the number of words and then the words
+                if (offset >= code.size()) {
+                    return false;
+                }
+                offset += 1 + (code[offset] * 2);
+            }
+            else if (IsConditionValid(b)) {
+                const size_t argc = GetNumberOfConditionArguments(b);
+                if ((offset + argc) > code.size()) {
+                    return false;
+                }
+                std::copy(code.data() + offset, code.data() + offset + argc, condition.arguments);
+                offset += argc;
+            }
+            else {
+                return false;
+            }
+            if (inGroup) {
+                if (conditions[group].count == 0xff) {
+                    return false;
+                }
+                ++conditions[group].count;
+            }
+            conditions.push_back(condition);
+        }
+    }
+    return false;
+}
+
+bool GetU16(array_view<uint8_t> code, size_t& offset, uint16_t& value)
+{
+    if ((offset + 2) < code.size()) {
+        value = U16_LE(&code[offset]);
+        offset += 2;
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+void TranslateScript(
+    array_view<uint8_t> code,
+    std::vector<Instruction>& result,
+    std::vector<Condition>& conditions,
+    std::vector<uint32_t>* codeOffsets)
+{
+    result.clear();
+    conditions.clear();
+    std::vector<size_t> offsets;    // the code offset of each instruction
+    std::vector<size_t> targets;    // the code offset of each jump target
+
+    size_t offset = 0;
+    while(offset < code.size()) {
+        Instruction instruction = {};
+        size_t target = 0;
+        offsets.push_back(offset);
+
+        const uint8_t cmd = code[offset++];
+        uint16_t value = 0;
+        if (cmd == 0xff) {
+            instruction.kind = Instruction::kIf;
+            instruction.condition = static_cast<uint32_t>(conditions.size());
+            if (CompileConditions(code, offset, conditions) && GetU16(code, offset, value)) {
+                // the distance is relative to the end of the instruction
+                target = offset + value;
+                instruction.conditionCount = static_cast<uint32_t>(
+                    conditions.size() - instruction.condition);
+            }
+            else {
+                instruction.kind = Instruction::kInvalid;
+            }
+        }
+        else if (cmd == 0xfe) {
+            instruction.kind = Instruction::kGoto;
+            if (GetU16(code, offset, value)) {
+                target = offset + static_cast<int16_t>(value);
+            }
+            else {
+                instruction.kind = Instruction::kInvalid;
+            }
+        }
+        else if (IsCommandValid(cmd) &&
+                 ((offset + GetNumberOfArguments(cmd)) <= code.size())) {
+            instruction.kind = Instruction::kCommand;
+            instruction.command = cmd;
+            const size_t argc = GetNumberOfArguments(cmd);
+            std::copy(code.data() + offset, code.data() + offset + argc, instruction.arguments);
+            offset += argc;
+        }
+        else {
+            instruction.kind = Instruction::kInvalid;
+        }
+
+        result.push_back(instruction);
+        targets.push_back(target);
+        if (instruction.kind == Instruction::kInvalid) {
+            // nothing after this can be decoded
+            break;
+        }
+    }
+
+    if (codeOffsets) {
+        codeOffsets->assign(offsets.begin(), offsets.end());
+    }
+
+    // translate the jump targets into instruction indices
+    for(size_t i = 0; i < result.size(); ++i) {
+        auto& instruction = result[i];
+        if ((instruction.kind != Instruction::kIf) && (instruction.kind != Instruction::kGoto)) {
+            continue;
+        }
+        if (targets[i] >= code.size()) {
+            // jumps past the end of the logic
+            instruction.target = static_cast<uint32_t>(result.size());
+            continue;
+        }
+        auto it = std::lower_bound(offsets.begin(), offsets.end(), targets[i]);
+        if ((it == offsets.end()) && (result.back().kind == Instruction::kInvalid)) {
+            // jumps past the point where the decoding stopped
+            instruction.target = static_cast<uint32_t>(result.size() - 1);
+            continue;
+        }
+        if ((it == offsets.end()) || (*it != targets[i])) {
+            throw std::runtime_error(
+                "Script jumps into the middle of an instruction.");
+        }
+        instruction.target = static_cast<uint32_t>(it - offsets.begin());
+    }
+}
+
+} // namespace agi
@@ -3,20 +3,48 @@
 #include <agi/util.h>
 #include <stack>
 #include <chrono>
+#include <ctime>
 #include <assert.h>
 #include <boost/optional.hpp>
 
 namespace agi {
 
-Interpreter::Interpreter(const boost::filesystem::path& path) :
-    volumes_(path),
-    scripts_(volumes_, path / "LOGDIR"),
-    views_(volumes_, path / "VIEWDIR"),
-    pictures_(volumes_, path / "PICDIR")
+Interpreter::Interpreter(
+    const boost::filesystem::path& path,
+    const InterpreterOptions& options) :
+    Interpreter(std::make_shared<GameData>(path, options), options)
+{
+    // empty
+}
+
+Interpreter::Interpreter(
+    std::shared_ptr<GameData> game,
+    const InterpreterOptions& options) :
+    game_(std::move(game)),
+    scripts_(game_->GetScripts()),
+    pictures_(game_->GetPictures()),
+    views_(game_->GetViews()),
+    profiler_(options.profiler),
+    timeFinishCycle_(options.timeFinishCycle),
+    random_(options.seed)
 {
     // set all the variables to zero
     std::fill(variables_.begin(), variables_.end(), 0);
     SetInitialState();
+    // restarting the game restores this state instead of loading it again
+    initialState_ = CaptureSnapshot();
+}
+
+Interpreter::~Interpreter()
+{
+    // the game data may outlive the interpreter, and the caches are only
+    // trimmed when the pins are gone
+    for(auto& object : objects_) {
+        object.animation.viewInstance.reset();
+    }
+    std::fill(loadedPictures_.begin(), loadedPictures_.end(), nullptr);
+    views_.Trim();
+    pictures_.Trim();
 }
 
 void Interpreter::SetInitialState()
@@ -44,10 +72,10 @@ unsigned Interpreter::GetCycleDelay() const noexcept
     return GetVariable(Variable::kCycleDelayTime) * 50;
 }
 
-void Interpreter::OnKeyPress(SDL_Keysym keySym)
+void Interpreter::OnKeyPress(const KeyEvent& key)
 {
-    keys_.push_back(keySym);
-    SetVariable(Variable::kPressedKey, keySym.scancode);
+    keys_.push_back(key);
+    SetVariable(Variable::kPressedKey, key.code);
 }
 
 void Interpreter::UpdateClock()
@@ -55,14 +83,40 @@ void Interpreter::UpdateClock()
     // update the variables that indicates the interpreters internal clock.
     auto now = std::chrono::system_clock::now();
     std::time_t tm = std::chrono::system_clock::to_time_t(now);
-    if (auto lm = std::localtime(&tm)) {
-        SetVariable(Variable::kClockSeconds, lm->tm_sec);
-        SetVariable(Variable::kClockMinutes, lm->tm_min);
-        SetVariable(Variable::kClockHours, lm->tm_hour);
-        SetVariable(Variable::kClockDay, lm->tm_mday);
+    // std::localtime isn't thread safe, and the interpreters may run on
+    // several threads
+    std::tm local;
+#ifdef _WIN32
+    const bool ok = localtime_s(&local, &tm) == 0;
+#else
+    const bool ok = localtime_r(&tm, &local) != nullptr;
+#endif
+    if (ok) {
+        SetVariable(Variable::kClockSeconds, local.tm_sec);
+        SetVariable(Variable::kClockMinutes, local.tm_min);
+        SetVariable(Variable::kClockHours, local.tm_hour);
+        SetVariable(Variable::kClockDay, local.tm_mday);
     }
 }
 
+uint64_t Interpreter::GetStateChecksum() const
+{
+    // FNV-1a
+    uint64_t result = 0xcbf29ce484222325ull;
+    auto add = [&result](uint8_t value) {
+        result ^= value;
+        result *= 0x100000001b3ull;
+    };
+    for(size_t i = 0; i < variables_.size(); ++i) {
+        const bool clock = (i >= kClockSeconds) && (i <= kClockDay);
+        add(clock ? 0 : variables_[i]);
+    }
+    for(size_t i = 0; i < flags_.size(); ++i) {
+        add(flags_.test(i) ? 1 : 0);
+    }
+    return result;
+}
+
 void Interpreter::NewRoom(uint8_t room)
 {
     // - stop.update
@@ -101,7 +155,7 @@ void Interpreter::Call(uint8_t logicNumber)
 {
     SetFlag(Flag::kRoomScriptExecutedForFirstTime, !roomFlags_.test(logicNumber));
     roomFlags_.set(logicNumber);
-    scriptStack_.emplace_back(scripts_.GetScript(logicNumber));
+    scriptStack_.emplace_back(logicNumber, scripts_.GetScript(logicNumber));
 }
 
 void Interpreter::ShowPic()
@@ -123,7 +177,10 @@ void Interpreter::DisplayMessage(uint8_t row, uint8_t col, uint8_t msgIndex, con
     if (0 == msgIndex) {
         return;
     }
-    if (const char* pmsg = script.messages.at(msgIndex - 1)) {
+    if (msgIndex > script.messages.size()) {
+        throw std::out_of_range("Invalid message index.");
+    }
+    if (const char* pmsg = script.messages[msgIndex - 1]) {
         pictureBuffer_.Display(row, col, pmsg);
     }
 }
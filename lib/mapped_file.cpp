@@ -0,0 +1,70 @@
+#include <agi/mapped_file.h>
+#include <agi/util.h>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace agi {
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const boost::filesystem::path& filename) :
+    data_(nullptr),
+    size_(0)
+{
+    ReadFile(filename, buffer_);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile()
+{
+    // empty
+}
+
+#else
+
+MappedFile::MappedFile(const boost::filesystem::path& filename) :
+    data_(nullptr),
+    size_(0)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::invalid_argument("Could not open file");
+    }
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode)) {
+        close(fd);
+        throw std::invalid_argument("Could not open file");
+    }
+    if (0 == st.st_size) {
+        close(fd);
+        throw std::runtime_error("File is empty, can't map any data");
+    }
+
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps its own reference to the file
+    close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Failed to map file.");
+    }
+    data_ = static_cast<const uint8_t*>(addr);
+    size_ = static_cast<size_t>(st.st_size);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+#endif
+
+} // namespace agi
@@ -0,0 +1,59 @@
+#include <agi/native_module.h>
+#include <agi/interpreter.h>
+
+namespace agi {
+
+bool NativeContext::Command(uint8_t cmd, const uint8_t* arguments)
+{
+    auto& interpreter = interpreter_;
+    const auto handler = Interpreter::GetCommandHandlers()[cmd];
+#ifdef AGI_ENABLE_PROFILER
+    if (interpreter.profiler_) {
+        const auto start = Profiler::Clock::now();
+        (interpreter.*handler)(cmd, arguments);
+        interpreter.profiler_->AddCommand(cmd, Profiler::Clock::now() - start);
+    }
+    else {
+        (interpreter.*handler)(cmd, arguments);
+    }
+#else
+    (interpreter.*handler)(cmd, arguments);
+#endif
+    switch(static_cast<ActionCommand>(cmd)) {
+    case ActionCommand::kReturn:
+    case ActionCommand::kCall:
+    case ActionCommand::kCallV:
+    case ActionCommand::kNewRoom:
+    case ActionCommand::kNewRoomV:
+    case ActionCommand::kRestoreGame:
+    case ActionCommand::kRestartGame:
+        // the script stack has changed
+        return false;
+    default:
+        return !interpreter.request_;
+    }
+}
+
+bool NativeContext::Test(uint8_t test, uint8_t a0, uint8_t a1, uint8_t a2, uint8_t a3, uint8_t a4)
+{
+    const Condition condition = {test, false, 0, {a0, a1, a2, a3, a4}};
+#ifdef AGI_ENABLE_PROFILER
+    if (interpreter_.profiler_) {
+        return interpreter_.ProfileTest(condition);
+    }
+#endif
+    return interpreter_.Test(condition);
+}
+
+uint64_t GetCodeChecksum(array_view<uint8_t> code)
+{
+    // FNV-1a
+    uint64_t result = 0xcbf29ce484222325ull;
+    for(size_t i = 0; i < code.size(); ++i) {
+        result ^= code[i];
+        result *= 0x100000001b3ull;
+    }
+    return result;
+}
+
+} // namespace agi
@@ -1,6 +1,7 @@
 #include <agi/interpreter.h>
 #include <agi/object.h>
 #include <agi/view.h>
+#include <cmath>
 
 namespace agi {
 
@@ -62,6 +63,8 @@ void Interpreter::SetObjectView(uint8_t id, uint8_t view)
 {
     auto& obj = GetObject(id);
     obj.animation.SetView(view, views_.GetView(view));
+    // the previous view of the object may be evicted now
+    views_.Trim();
 }
 
 void Interpreter::Reposition(uint8_t id, uint8_t x, uint8_t y)
@@ -421,6 +424,8 @@ namespace {
 void PaintCel(
     Framebuffer& framebuffer, const Cel& cel, size_t x, size_t y, uint8_t priority, size_t loopIndex)
 {
+    // the cel is decoded the first time it's painted
+    const auto pixels = cel.GetPixels();
     // for each pixel row in the cel
     int startY = y - cel.height + 1;
     for(uint8_t row = 0; row < cel.height; ++row) {
@@ -435,10 +440,10 @@ void PaintCel(
             uint8_t pixel;
             // check if we should mirror the cel
             if (cel.mirrored && (cel.mirrorLoop != loopIndex)) {
-                pixel = cel.pixels[(row * cel.width) + (cel.width - col - 1)];
+                pixel = pixels[(row * cel.width) + (cel.width - col - 1)];
             }
             else {
-                pixel = cel.pixels[(row * cel.width) + col];
+                pixel = pixels[(row * cel.width) + col];
             }
             if (pixel != cel.colorKey) {
                 // only draw the pixel if it's not transparent
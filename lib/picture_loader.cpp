@@ -1,37 +1,82 @@
 #include <agi/picture_loader.h>
 #include <agi/picture.h>
+#include <chrono>
 
 namespace agi {
 
 PictureLoader::PictureLoader(
-    VolumeLoader& volumes,
-    const boost::filesystem::path& directoryFile) :
-    volumes_(volumes)
+    const ResourceIndex& resources,
+    size_t cacheBudget,
+    std::shared_ptr<ResourceEventSink> events) :
+    resources_(resources),
+    events_(events ? std::move(events) : std::make_shared<NullEventSink>()),
+    reportHits_(events_->WantsHits()),
+    cache_(cacheBudget)
 {
-    agi::ParseDirectoryFile(directoryFile, entries_);
+    // empty
+}
+
+void PictureLoader::Trim()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.Trim();
 }
 
 void PictureLoader::DrawPicture(uint8_t picture, Framebuffer& framebuffer)
 {
-    framebuffer.Clear();
-    OverlayPicture(picture, framebuffer);
+    framebuffer = *LoadPicture(picture);
+    // the whole screen is replaced, whatever rows the cached copy has marked
+    framebuffer.MarkDirty(0, Framebuffer::kHeight);
 }
 
 void PictureLoader::OverlayPicture(uint8_t picture, Framebuffer& framebuffer)
 {
-    if (picture >= entries_.size()) {
-        throw std::invalid_argument(
-            "Invalid script index, no such directory entry.");
+    // the picture data is the same in the volumes and in an archive
+    auto data = resources_.Get(ResourceType::kPicture, picture);
+    Source source(data.data(), data.size());
+    agi::DrawPicture(source, framebuffer);
+}
+
+std::shared_ptr<const Framebuffer> PictureLoader::LoadPicture(uint8_t picture)
+{
+    std::shared_ptr<const Framebuffer> rendered;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rendered = cache_.Find(picture);
+    }
+    if (rendered) {
+        if (reportHits_) {
+            events_->OnResourceEvent(ResourceEvent{ResourceType::kPicture, picture, true});
+        }
+        return rendered;
     }
-    auto& entry = entries_[picture];
+    // drawing a picture always starts from a cleared framebuffer, so the
+    // result only depends on the picture number. It's rendered without
+    // holding the lock, so other pictures can be drawn meanwhile.
+    const auto start = std::chrono::steady_clock::now();
+    auto framebuffer = std::make_shared<Framebuffer>();
+    OverlayPicture(picture, *framebuffer);
+
+    ResourceEvent event{ResourceType::kPicture, picture, false};
+    event.data = resources_.Get(ResourceType::kPicture, picture);
+    event.size = event.data.size();
+    event.decodeTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    events_->OnResourceEvent(event);
 
-    auto volume = volumes_.GetVolume(entry.volume);
-    // make sure that the offset is valid
-    if (entry.offset >= volume.size()) {
-        throw std::invalid_argument("Invalid volume offset.");
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto existing = cache_.Peek(picture)) {
+        // rendered by another thread at the same time
+        return existing;
     }
+    cache_.Insert(picture, framebuffer, sizeof(Framebuffer));
+    return framebuffer;
+}
 
-    DrawPictureResource(volume, entry.offset, framebuffer);
+CacheStatistics PictureLoader::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cache_.GetStatistics();
 }
 
 } // namespace agi
@@ -0,0 +1,182 @@
+#include <agi/profiler.h>
+#include <agi/commands.h>
+#include <algorithm>
+#include <iomanip>
+#include <string>
+
+namespace agi {
+
+namespace {
+
+struct Row
+{
+    std::string name;
+    int logic = -1;         // -1 if the row isn't a logic or an instruction
+    int offset = -1;        // -1 if the row isn't an instruction
+    Profiler::Counter counter;
+};
+
+uint64_t GetNanoseconds(Profiler::Clock::duration time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+const char* GetInstructionName(uint8_t command)
+{
+    return (command == Profiler::kNative) ? "native" : GetCommandName(command);
+}
+
+void SortByTime(std::vector<Row>& rows)
+{
+    std::stable_sort(rows.begin(), rows.end(), [](const Row& lhs, const Row& rhs) {
+        return lhs.counter.time > rhs.counter.time;
+    });
+}
+
+std::vector<Row> GetRows(const std::array<Profiler::Counter, 256>& counters, const char* (*name)(uint8_t))
+{
+    std::vector<Row> result;
+    for(size_t i = 0; i < counters.size(); ++i) {
+        if (counters[i].count) {
+            Row row;
+            row.name = name(static_cast<uint8_t>(i));
+            row.counter = counters[i];
+            result.push_back(row);
+        }
+    }
+    SortByTime(result);
+    return result;
+}
+
+/**
+ * \brief   Returns a row for every executed instruction of every logic
+ */
+template<class Instructions>
+std::vector<Row> GetInstructionRows(const Instructions& logics)
+{
+    std::vector<Row> result;
+    for(size_t logic = 0; logic < logics.size(); ++logic) {
+        for(size_t offset = 0; offset < logics[logic].size(); ++offset) {
+            const auto& counter = logics[logic][offset];
+            if (counter.count) {
+                Row row;
+                row.name = GetInstructionName(counter.command);
+                row.logic = static_cast<int>(logic);
+                row.offset = static_cast<int>(offset);
+                row.counter = counter;
+                result.push_back(row);
+            }
+        }
+    }
+    SortByTime(result);
+    return result;
+}
+
+void WriteRows(std::ostream& out, const char* title, const std::vector<Row>& rows)
+{
+    out << title << '\n';
+    out << "  " << std::left << std::setw(24) << "name" << std::right
+        << std::setw(8) << "logic" << std::setw(8) << "offset"
+        << std::setw(14) << "count" << std::setw(14) << "time (us)"
+        << std::setw(12) << "ns/exec" << '\n';
+    for(auto& row : rows) {
+        const uint64_t ns = GetNanoseconds(row.counter.time);
+        out << "  " << std::left << std::setw(24) << row.name << std::right;
+        if (row.logic >= 0) {
+            out << std::setw(8) << row.logic;
+        }
+        else {
+            out << std::setw(8) << "";
+        }
+        if (row.offset >= 0) {
+            out << std::setw(8) << row.offset;
+        }
+        else {
+            out << std::setw(8) << "";
+        }
+        out << std::setw(14) << row.counter.count
+            << std::setw(14) << (ns / 1000)
+            << std::setw(12) << (ns / row.counter.count) << '\n';
+    }
+    out << '\n';
+}
+
+} // namespace
+
+void Profiler::Merge(const Profiler& other)
+{
+    for(size_t i = 0; i < commands_.size(); ++i) {
+        commands_[i].count += other.commands_[i].count;
+        commands_[i].time += other.commands_[i].time;
+        tests_[i].count += other.tests_[i].count;
+        tests_[i].time += other.tests_[i].time;
+    }
+    for(size_t logic = 0; logic < instructions_.size(); ++logic) {
+        auto& instructions = instructions_[logic];
+        const auto& others = other.instructions_[logic];
+        if (instructions.size() < others.size()) {
+            instructions.resize(others.size());
+        }
+        for(size_t offset = 0; offset < others.size(); ++offset) {
+            if (others[offset].count) {
+                instructions[offset].command = others[offset].command;
+                instructions[offset].count += others[offset].count;
+                instructions[offset].time += others[offset].time;
+            }
+        }
+    }
+}
+
+void Profiler::WriteReport(std::ostream& out, size_t maxInstructions) const
+{
+    WriteRows(out, "commands", GetRows(commands_, GetCommandName));
+    WriteRows(out, "tests", GetRows(tests_, GetConditionName));
+
+    auto instructions = GetInstructionRows(instructions_);
+    std::vector<Row> logics;
+    for(auto& row : instructions) {
+        auto it = std::find_if(logics.begin(), logics.end(),
+            [&row](const Row& logic) { return logic.logic == row.logic; });
+        if (it == logics.end()) {
+            Row logic;
+            logic.name = "logic";
+            logic.logic = row.logic;
+            it = logics.insert(logics.end(), logic);
+        }
+        it->counter.count += row.counter.count;
+        it->counter.time += row.counter.time;
+    }
+    SortByTime(logics);
+    if (instructions.size() > maxInstructions) {
+        instructions.resize(maxInstructions);
+    }
+    WriteRows(out, "logics", logics);
+    WriteRows(out, "instructions", instructions);
+}
+
+void Profiler::WriteCsv(std::ostream& out) const
+{
+    out << "kind,name,logic,offset,count,time_ns\n";
+    auto write = [&out](const char* kind, const Row& row) {
+        out << kind << ',' << row.name << ',';
+        if (row.logic >= 0) {
+            out << row.logic;
+        }
+        out << ',';
+        if (row.offset >= 0) {
+            out << row.offset;
+        }
+        out << ',' << row.counter.count << ',' << GetNanoseconds(row.counter.time) << '\n';
+    };
+    for(auto& row : GetRows(commands_, GetCommandName)) {
+        write("command", row);
+    }
+    for(auto& row : GetRows(tests_, GetConditionName)) {
+        write("test", row);
+    }
+    for(auto& row : GetInstructionRows(instructions_)) {
+        write("instruction", row);
+    }
+}
+
+} // namespace agi
@@ -0,0 +1,71 @@
+#include <agi/resource_events.h>
+#include <string>
+#include <utility>
+#include <stdio.h>
+
+namespace agi {
+
+void CountingEventSink::OnResourceEvent(const ResourceEvent& event)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& counters = counters_[static_cast<size_t>(event.type)];
+    if (event.cacheHit) {
+        ++counters.hits;
+    }
+    else {
+        ++counters.misses;
+        counters.bytes += event.size;
+        counters.decodeTime += event.decodeTime;
+    }
+}
+
+ResourceCounters CountingEventSink::GetCounters(ResourceType type) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return counters_[static_cast<size_t>(type)];
+}
+
+DumpEventSink::DumpEventSink(const boost::filesystem::path& directory) :
+    directory_(directory)
+{
+    // empty
+}
+
+void DumpEventSink::OnResourceEvent(const ResourceEvent& event)
+{
+    if ((event.type != ResourceType::kLogic) || event.cacheHit) {
+        return;
+    }
+    const auto filename = directory_ / ("script" + std::to_string(event.index) + ".txt");
+    if (FILE* fp = fopen(filename.string().c_str(), "wb")) {
+        fwrite(event.data.data(), event.data.size(), 1, fp);
+        fclose(fp);
+    }
+}
+
+FanOutEventSink::FanOutEventSink(std::vector<std::shared_ptr<ResourceEventSink>> sinks) :
+    sinks_(std::move(sinks))
+{
+    // empty
+}
+
+void FanOutEventSink::OnResourceEvent(const ResourceEvent& event)
+{
+    for(auto& sink : sinks_) {
+        if (!event.cacheHit || sink->WantsHits()) {
+            sink->OnResourceEvent(event);
+        }
+    }
+}
+
+bool FanOutEventSink::WantsHits() const
+{
+    for(auto& sink : sinks_) {
+        if (sink->WantsHits()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace agi
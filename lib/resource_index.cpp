@@ -0,0 +1,84 @@
+#include <agi/resource_index.h>
+#include <agi/util.h>
+#include <stdexcept>
+
+namespace agi {
+
+ResourceIndex::ResourceIndex(VolumeLoader& volumes, const boost::filesystem::path& gameDirectory)
+{
+    std::vector<DirectoryEntry> entries;
+    ParseDirectoryFile(gameDirectory / "LOGDIR", entries);
+    Add(volumes, ResourceType::kLogic, entries);
+    ParseDirectoryFile(gameDirectory / "PICDIR", entries);
+    Add(volumes, ResourceType::kPicture, entries);
+    ParseDirectoryFile(gameDirectory / "VIEWDIR", entries);
+    Add(volumes, ResourceType::kView, entries);
+}
+
+ResourceIndex::ResourceIndex(
+    VolumeLoader& volumes,
+    const std::vector<DirectoryEntry>& logics,
+    const std::vector<DirectoryEntry>& pictures,
+    const std::vector<DirectoryEntry>& views)
+{
+    Add(volumes, ResourceType::kLogic, logics);
+    Add(volumes, ResourceType::kPicture, pictures);
+    Add(volumes, ResourceType::kView, views);
+}
+
+ResourceIndex::ResourceIndex(std::shared_ptr<const GameArchive> archive) :
+    archive_(std::move(archive))
+{
+    for(size_t type = 0; type < entries_.size(); ++type) {
+        for(size_t i = 0; i < 256; ++i) {
+            const auto resourceType = static_cast<ResourceType>(type);
+            const auto index = static_cast<uint8_t>(i);
+            if (archive_->Contains(resourceType, index)) {
+                auto& entry = entries_[type][i];
+                entry.state = ResourceEntry::kValid;
+                entry.data = archive_->GetResource(resourceType, index);
+            }
+        }
+    }
+}
+
+void ResourceIndex::Add(
+    VolumeLoader& volumes,
+    ResourceType type,
+    const std::vector<DirectoryEntry>& entries)
+{
+    auto& result = entries_[static_cast<size_t>(type)];
+    for(size_t i = 0; (i < entries.size()) && (i < result.size()); ++i) {
+        const auto& directoryEntry = entries[i];
+        if (IsMissing(directoryEntry)) {
+            continue;
+        }
+        auto& entry = result[i];
+        entry.volume = directoryEntry.volume;
+        entry.offset = directoryEntry.offset;
+        try {
+            // checks the magic number and that the resource fits
+            entry.data = ParseResource(volumes.GetVolume(entry.volume), entry.offset);
+            entry.state = ResourceEntry::kValid;
+        }
+        catch(std::exception& e) {
+            entry.state = ResourceEntry::kInvalid;
+            entry.error = e.what();
+        }
+    }
+}
+
+array_view<uint8_t> ResourceIndex::Get(ResourceType type, uint8_t index) const
+{
+    const auto& entry = GetEntry(type, index);
+    switch(entry.state) {
+    case ResourceEntry::kValid:
+        return entry.data;
+    case ResourceEntry::kInvalid:
+        throw std::runtime_error("Invalid resource: " + entry.error);
+    default:
+        throw std::invalid_argument("Invalid resource index, no such resource.");
+    }
+}
+
+} // namespace agi
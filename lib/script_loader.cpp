@@ -1,119 +1,170 @@
 #include <agi/script_loader.h>
 #include <agi/util.h>
 
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
-#include <sstream>
 
 namespace agi {
 
 ScriptLoader::ScriptLoader(
-    VolumeLoader& volumes,
-    const boost::filesystem::path& directoryFile) :
-    volumes_(volumes)
+    const ResourceIndex& resources,
+    std::shared_ptr<ResourceEventSink> events,
+    const NativeModule* module) :
+    resources_(resources),
+    events_(events ? std::move(events) : std::make_shared<NullEventSink>()),
+    reportHits_(events_->WantsHits()),
+    module_(module)
 {
-    agi::ParseDirectoryFile(directoryFile, entries_);
+    for(auto& loaded : loaded_) {
+        loaded.store(false, std::memory_order_relaxed);
+    }
 }
 
-std::shared_ptr<Script> ScriptLoader::GetScript(uint8_t index)
+std::shared_ptr<const Script> ScriptLoader::GetScript(uint8_t index)
 {
-    if (auto script = scripts_[index]) {
-        // script already loaded, so just return it
-        return script;
-    }
-    else {
-        // script is not loaded, so load it and return it
-        return LoadScript(index);
-    }
+    // the script is loaded if it isn't already
+    return LoadScript(index);
 }
 
 namespace {
-   
-void Decrypt(const uint8_t* startp, size_t count, std::vector<char>& result)
+
+/**
+ * \brief   The key repeated so that a block always starts with the first
+ *          character of the key, which keeps the inner loop free from
+ *          divisions and lets the compiler vectorize it.
+ */
+struct KeyStream
 {
-    const char key[] = "Avis Durgan";
-    auto keyLength = strlen(key);
+    enum {
+        kKeyLength = 11,
+        kBlockSize = kKeyLength * 16
+    };
+
+    KeyStream()
+    {
+        const char key[] = "Avis Durgan";
+        static_assert(sizeof(key) == (kKeyLength + 1), "Unexpected key length.");
+        for(size_t i = 0; i < kBlockSize; ++i) {
+            bytes[i] = static_cast<uint8_t>(key[i % kKeyLength]);
+        }
+    }
+
+    uint8_t bytes[kBlockSize];
+};
 
-    result.reserve(count);
-    for(size_t i = 0; i < count; ++i) {
-        result.push_back(startp[i] ^ key[i % keyLength]);
+void Decrypt(const uint8_t* source, size_t count, char* destination)
+{
+    static const KeyStream keys;
+    while(count > 0) {
+        const size_t n = std::min<size_t>(count, KeyStream::kBlockSize);
+        for(size_t i = 0; i < n; ++i) {
+            destination[i] = static_cast<char>(source[i] ^ keys.bytes[i]);
+        }
+        source += n;
+        destination += n;
+        count -= n;
     }
 }
 
-std::shared_ptr<Script> ParseScriptResource(
-    array_view<uint8_t> volume,
-    size_t offset,
-    size_t scriptIndex)
-{
-    auto data = ParseResource(volume, offset);
+} // namespace
 
+std::shared_ptr<Script> ParseScript(array_view<uint8_t> data, StringArena& strings)
+{
     // make sure that the text offset fits
     if (data.size() < 2) {
         throw std::runtime_error(
             "Text offset does not fit inside the script resource.");
     }
     // mstart
-    const auto messageStart = U16_LE(&data[0]) + 2; // actual offset to messages
+    const size_t messageStart = U16_LE(&data[0]) + 2; // actual offset to messages
+    if ((messageStart + 3) > data.size()) {
+        throw std::runtime_error(
+            "Message header does not fit inside the script resource.");
+    }
     // mc
-    const auto messageCount = data[messageStart];   // the number of messages
-    const auto messageEnd   = U16_LE(&data[messageStart + 1]) + messageStart + 1;
-    const auto messageData  = messageStart + 3 + (messageCount * 2);
-
-
-    std::stringstream ss;
-    ss << "/tmp/script" << ((unsigned) scriptIndex) << ".txt";
-    if (FILE* fp=fopen(ss.str().c_str(), "wb")) {
-        fwrite(data.data(), data.size(), 1, fp);
-        fclose(fp);
+    const size_t messageCount = data[messageStart];   // the number of messages
+    const size_t messageData  = messageStart + 3 + (messageCount * 2);
+    const size_t messageEnd   = std::min<size_t>(
+        U16_LE(&data[messageStart + 1]) + messageStart + 1, data.size());
+    if (messageData > messageEnd) {
+        throw std::runtime_error(
+            "Message offsets does not fit inside the script resource.");
     }
 
     // create script instance
     auto result = std::make_shared<Script>();
     // the actual script
-    result->code = array_view<uint8_t>(&data[2], messageStart - 2);
-    // decrypt extract the message data
-    Decrypt(&data[messageData], messageEnd - messageData, result->stringData);
+    result->code = array_view<uint8_t>(data.data() + 2, messageStart - 2);
+    // decrypt the message data into the arena, the terminator makes sure
+    // that the last message is null-terminated
+    const size_t stringSize = messageEnd - messageData;
+    char* stringData = strings.AllocateString(stringSize + 1);
+    Decrypt(data.data() + messageData, stringSize, stringData);
+    stringData[stringSize] = '\0';
     // extract the message offsets
+    auto messages = strings.AllocateArray<const char*>(messageCount);
     for(size_t i = 0; i < messageCount; ++i) {
         // read the encoded offset
         size_t offsetValue = U16_LE(&data[messageStart + 3 + (i * 2)]);
         size_t stringPos = messageStart + offsetValue + 1;
-        if (stringPos < messageData) {
-            // Not a valid string
-            result->messages.push_back(nullptr);
-        }
-        else {
-            auto bufferIndex = stringPos - messageData;
-            result->messages.push_back(&result->stringData[bufferIndex]);
+        if ((stringPos >= messageData) && (stringPos < messageEnd)) {
+            messages[i] = stringData + (stringPos - messageData);
         }
+        // otherwise it's not a valid string, and left as nullptr
     }
+    result->messages = array_view<const char*>(messages, messageCount);
     return result;
 }
 
-} // namespace
-
-std::shared_ptr<Script> ScriptLoader::LoadScript(uint8_t index)
+std::shared_ptr<const Script> ScriptLoader::LoadScript(uint8_t index)
 {
-    if (auto script = scripts_[index]) {
+    if (loaded_[index].load(std::memory_order_acquire)) {
         // script already loaded, so just return it
-        return script;
+        if (reportHits_) {
+            events_->OnResourceEvent(ResourceEvent{ResourceType::kLogic, index, true});
+        }
+        return scripts_[index];
     }
 
-    if (index >= entries_.size()) {
-        throw std::invalid_argument(
-            "Invalid script index, no such directory entry.");
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loaded_[index].load(std::memory_order_relaxed)) {
+        // loaded by another thread while waiting for the lock
+        if (reportHits_) {
+            events_->OnResourceEvent(ResourceEvent{ResourceType::kLogic, index, true});
+        }
+        return scripts_[index];
     }
-    auto& entry = entries_[index];
 
-    // get the volume that contains the script
-    auto volume = volumes_.GetVolume(entry.volume);
-    // make sure that the offset is valid
-    if (entry.offset >= volume.size()) {
-        throw std::invalid_argument("Invalid volume offset.");
+    const auto start = std::chrono::steady_clock::now();
+    auto data = resources_.Get(ResourceType::kLogic, index);
+    std::shared_ptr<Script> script;
+    if (auto& archive = resources_.GetArchive()) {
+        // already decoded, the script refers to the archive data
+        script = archive->LoadScript(index, strings_);
+    }
+    else {
+        script = ParseScript(data, strings_);
+    }
+    TranslateScript(script->code, script->instructions, script->conditions, &script->offsets);
+    if (module_) {
+        // only if the logic was translated from the same code
+        const auto& logic = module_->logics[index];
+        if (logic.function && (logic.checksum == GetCodeChecksum(script->code))) {
+            script->native = logic.function;
+        }
     }
 
-    scripts_[index] = ParseScriptResource(volume, entry.offset, index);
+    ResourceEvent event{ResourceType::kLogic, index, false};
+    event.size = data.size();
+    event.decodeTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    event.data = data;
+    events_->OnResourceEvent(event);
 
-    return scripts_[index];
+    scripts_[index] = script;
+    loaded_[index].store(true, std::memory_order_release);
+    return script;
 }
 
 } // namespace agi
@@ -0,0 +1,382 @@
+#include <agi/interpreter.h>
+#include <agi/util.h>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace agi {
+
+namespace {
+
+const char kMagic[4] = {'A', 'G', 'I', 'S'};
+
+/**
+ * \class   SnapshotWriter
+ */
+class SnapshotWriter
+{
+public:
+    explicit SnapshotWriter(std::vector<uint8_t>& data) :
+        data_(data)
+    {
+        // empty
+    }
+
+    void U8(uint8_t value) { data_.push_back(value); }
+
+    void U16(uint16_t value)
+    {
+        U8(value & 0xff);
+        U8(value >> 8);
+    }
+
+    void U32(uint32_t value)
+    {
+        U16(value & 0xffff);
+        U16(value >> 16);
+    }
+
+    void Bytes(const uint8_t* bytes, size_t size)
+    {
+        data_.insert(data_.end(), bytes, bytes + size);
+    }
+
+    void Bits(const std::bitset<256>& bits)
+    {
+        for(size_t i = 0; i < bits.size(); i += 8) {
+            uint8_t value = 0;
+            for(size_t j = 0; j < 8; ++j) {
+                value |= bits.test(i + j) ? (1 << j) : 0;
+            }
+            U8(value);
+        }
+    }
+
+private:
+    std::vector<uint8_t>& data_;
+};
+
+/**
+ * \class   SnapshotReader
+ */
+class SnapshotReader
+{
+public:
+    explicit SnapshotReader(const std::vector<uint8_t>& data) :
+        position_(data.data()),
+        end_(data.data() + data.size())
+    {
+        // empty
+    }
+
+    const uint8_t* Take(size_t size)
+    {
+        if (size > static_cast<size_t>(end_ - position_)) {
+            throw std::runtime_error("Invalid snapshot, the state is truncated.");
+        }
+        const uint8_t* result = position_;
+        position_ += size;
+        return result;
+    }
+
+    uint8_t U8() { return *Take(1); }
+    uint16_t U16() { return U16_LE(Take(2)); }
+    uint32_t U32() { return U32_LE(Take(4)); }
+
+    /**
+     * \brief   Reads an enum value, which must not be greater than last
+     */
+    template<class T>
+    T Enum(T last)
+    {
+        const uint8_t value = U8();
+        if (value > static_cast<uint8_t>(last)) {
+            throw std::runtime_error("Invalid snapshot, an enum is out of range.");
+        }
+        return static_cast<T>(value);
+    }
+
+    void Bytes(uint8_t* bytes, size_t size)
+    {
+        std::memcpy(bytes, Take(size), size);
+    }
+
+    void Bits(std::bitset<256>& bits)
+    {
+        for(size_t i = 0; i < bits.size(); i += 8) {
+            const uint8_t value = U8();
+            for(size_t j = 0; j < 8; ++j) {
+                bits[i + j] = (value >> j) & 0x01;
+            }
+        }
+    }
+
+    bool AtEnd() const noexcept { return position_ == end_; }
+
+private:
+    const uint8_t* position_;
+    const uint8_t* end_;
+};
+
+/**
+ * \brief   An object is stored as:
+ *
+ *              i32 x, i32 y, u8 xSize, u8 ySize, u8 direction, u8 motion,
+ *              u8 allowedSurface, u8 dstX, u8 dstY, u8 speed, u8 moveFlag,
+ *              u8 stepSize, u8 stepTime, u8 hasView, u8 view, u8 loop,
+ *              u8 cel, u8 cycleTime, u8 loops, u8 cels, u8 animationFlag,
+ *              u8 priority, u8 cycleType, u32 flags
+ */
+void WriteObject(SnapshotWriter& writer, const Object& object)
+{
+    const auto& movement = object.movement;
+    writer.U32(static_cast<uint32_t>(movement.x));
+    writer.U32(static_cast<uint32_t>(movement.y));
+    writer.U8(movement.xSize);
+    writer.U8(movement.ySize);
+    writer.U8(static_cast<uint8_t>(movement.direction));
+    writer.U8(static_cast<uint8_t>(movement.motion));
+    writer.U8(static_cast<uint8_t>(movement.allowedSurface));
+    writer.U8(movement.moveObj.dstX);
+    writer.U8(movement.moveObj.dstY);
+    writer.U8(movement.moveObj.speed);
+    writer.U8(movement.moveObj.flag);
+    writer.U8(movement.stepSize);
+    writer.U8(movement.stepTime);
+
+    const auto& animation = object.animation;
+    writer.U8(animation.viewInstance ? 1 : 0);
+    writer.U8(animation.viewIndex);
+    writer.U8(animation.loopIndex);
+    writer.U8(animation.celIndex);
+    writer.U8(animation.cycleTime);
+    writer.U8(animation.numberOfLoops);
+    writer.U8(animation.numberOfCels);
+    writer.U8(animation.flag);
+    writer.U8(animation.priority);
+    writer.U8(static_cast<uint8_t>(animation.cycleType));
+    writer.U32(object.flags);
+}
+
+void ReadObject(SnapshotReader& reader, ViewLoader& views, Object& object)
+{
+    auto& movement = object.movement;
+    movement.x = static_cast<int32_t>(reader.U32());
+    movement.y = static_cast<int32_t>(reader.U32());
+    movement.xSize = reader.U8();
+    movement.ySize = reader.U8();
+    movement.direction = reader.Enum(Direction::kNorthWest);
+    movement.motion = reader.Enum(Motion::kMoveObject);
+    movement.allowedSurface = reader.Enum(SurfaceType::kLand);
+    movement.moveObj.dstX = reader.U8();
+    movement.moveObj.dstY = reader.U8();
+    movement.moveObj.speed = reader.U8();
+    movement.moveObj.flag = reader.U8();
+    movement.stepSize = reader.U8();
+    movement.stepTime = reader.U8();
+
+    auto& animation = object.animation;
+    const bool hasView = reader.U8() != 0;
+    animation.viewIndex = reader.U8();
+    animation.viewInstance = hasView ? views.GetView(animation.viewIndex) : nullptr;
+    animation.loopIndex = reader.U8();
+    animation.celIndex = reader.U8();
+    animation.cycleTime = reader.U8();
+    animation.numberOfLoops = reader.U8();
+    animation.numberOfCels = reader.U8();
+    animation.flag = reader.U8();
+    animation.priority = reader.U8();
+    animation.cycleType = reader.Enum(AnimationCycle::kReverseCycle);
+    object.flags = reader.U32();
+}
+
+void WriteFramebuffer(SnapshotWriter& writer, const Framebuffer& framebuffer)
+{
+    const auto& picture = framebuffer.GetPictureBuffer();
+    const auto& priority = framebuffer.GetPriorityBuffer();
+    const auto& text = framebuffer.GetTextBuffer();
+    writer.Bytes(picture.data(), picture.size());
+    writer.Bytes(priority.data(), priority.size());
+    writer.Bytes(text.data(), text.size());
+}
+
+uint32_t GetRandomState(const std::minstd_rand& random)
+{
+    // the standard only exposes the state of an engine through a stream
+    std::ostringstream ss;
+    ss << random;
+    return static_cast<uint32_t>(std::stoul(ss.str()));
+}
+
+} // namespace
+
+Snapshot Interpreter::CaptureSnapshot(uint32_t contents) const
+{
+    Snapshot result;
+    auto& data = result.data;
+    data.reserve((contents & Snapshot::kFramebuffers) ? 160 * 1024 : 10 * 1024);
+    SnapshotWriter writer(data);
+    writer.Bytes(reinterpret_cast<const uint8_t*>(kMagic), sizeof(kMagic));
+    writer.U32(Snapshot::kVersion);
+    writer.U32(contents);
+
+    writer.Bytes(variables_.data(), variables_.size());
+    writer.Bits(flags_);
+    writer.Bits(roomFlags_);
+    writer.U8(horizon_);
+    writer.U8(programControl_ ? 1 : 0);
+    writer.U32(GetRandomState(random_));
+
+    writer.U16(static_cast<uint16_t>(keys_.size()));
+    for(auto& key : keys_) {
+        writer.U8(static_cast<uint8_t>(key.key));
+        writer.U8(key.code);
+    }
+
+    std::bitset<256> loaded;
+    for(size_t i = 0; i < loadedPictures_.size(); ++i) {
+        loaded[i] = loadedPictures_[i] != nullptr;
+    }
+    writer.Bits(loaded);
+
+    for(auto& object : objects_) {
+        WriteObject(writer, object);
+    }
+
+    writer.U16(static_cast<uint16_t>(scriptStack_.size()));
+    for(auto& state : scriptStack_) {
+        writer.U8(state.logic);
+        writer.U32(static_cast<uint32_t>(state.ip));
+    }
+
+    if (contents & Snapshot::kFramebuffers) {
+        WriteFramebuffer(writer, pictureBuffer_);
+        WriteFramebuffer(writer, framebuffer_);
+    }
+    return result;
+}
+
+void Interpreter::RestoreSnapshot(const Snapshot& snapshot)
+{
+    SnapshotReader reader(snapshot.data);
+    if (std::memcmp(reader.Take(sizeof(kMagic)), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Invalid snapshot, the magic number doesn't match.");
+    }
+    if (reader.U32() != Snapshot::kVersion) {
+        throw std::runtime_error("Unsupported snapshot version.");
+    }
+    const uint32_t contents = reader.U32();
+
+    // everything is read before the state is changed, so an invalid
+    // snapshot leaves the state as it is
+    std::array<uint8_t, 256> variables;
+    std::bitset<256> flags;
+    std::bitset<256> roomFlags;
+    reader.Bytes(variables.data(), variables.size());
+    reader.Bits(flags);
+    reader.Bits(roomFlags);
+    const uint8_t horizon = reader.U8();
+    const bool programControl = reader.U8() != 0;
+    const uint32_t random = reader.U32();
+
+    std::vector<KeyEvent> keys(reader.U16());
+    for(auto& key : keys) {
+        key.key = reader.Enum(Key::kDown);
+        key.code = reader.U8();
+    }
+
+    std::bitset<256> loaded;
+    reader.Bits(loaded);
+    std::array<std::shared_ptr<const Framebuffer>, 256> loadedPictures;
+    for(size_t i = 0; i < loadedPictures.size(); ++i) {
+        if (loaded.test(i)) {
+            loadedPictures[i] = pictures_.LoadPicture(static_cast<uint8_t>(i));
+        }
+    }
+
+    std::unique_ptr<std::array<Object, 256> > objects(new std::array<Object, 256>());
+    for(auto& object : *objects) {
+        ReadObject(reader, views_, object);
+    }
+
+    std::vector<ExecState> scriptStack;
+    const size_t stackSize = reader.U16();
+    scriptStack.reserve(stackSize);
+    for(size_t i = 0; i < stackSize; ++i) {
+        const uint8_t logic = reader.U8();
+        scriptStack.emplace_back(logic, scripts_.GetScript(logic));
+        scriptStack.back().ip = reader.U32();
+        if (scriptStack.back().ip > scriptStack.back().script->instructions.size()) {
+            throw std::runtime_error("Invalid snapshot, the instruction is outside the script.");
+        }
+    }
+
+    const uint8_t* framebuffers = nullptr;
+    if (contents & Snapshot::kFramebuffers) {
+        const size_t size = pictureBuffer_.GetPictureBuffer().size()
+            + pictureBuffer_.GetPriorityBuffer().size()
+            + pictureBuffer_.GetTextBuffer().size();
+        framebuffers = reader.Take(2 * size);
+    }
+    if (!reader.AtEnd()) {
+        throw std::runtime_error("Invalid snapshot, unexpected data after the state.");
+    }
+
+    variables_ = variables;
+    flags_ = flags;
+    roomFlags_ = roomFlags;
+    horizon_ = horizon;
+    programControl_ = programControl;
+    random_.seed(random);
+    keys_ = std::move(keys);
+    loadedPictures_ = std::move(loadedPictures);
+    objects_ = std::move(*objects);
+    scriptStack_ = std::move(scriptStack);
+    if (framebuffers) {
+        for(auto framebuffer : {&pictureBuffer_, &framebuffer_}) {
+            auto& picture = framebuffer->GetPictureBuffer();
+            auto& priority = framebuffer->GetPriorityBuffer();
+            std::memcpy(picture.data(), framebuffers, picture.size());
+            framebuffers += picture.size();
+            std::memcpy(priority.data(), framebuffers, priority.size());
+            framebuffers += priority.size();
+            framebuffer->SetTextBuffer(framebuffers);
+            framebuffers += framebuffer->GetTextBuffer().size();
+        }
+    }
+    pictures_.Trim();
+    views_.Trim();
+}
+
+void Interpreter::SaveGame()
+{
+    // the game is saved in memory, the screen is included since the logics
+    // don't redraw it after a restore
+    savedGame_ = CaptureSnapshot(Snapshot::kFramebuffers);
+}
+
+void Interpreter::RestoreGame()
+{
+    if (savedGame_.data.empty()) {
+        // nothing has been saved
+        return;
+    }
+    RestoreSnapshot(savedGame_);
+    SetFlag(Flag::kRestoreGameExecuted, true);
+    // the rest of the cycle is abandoned, the next cycle starts from the
+    // restored state
+    scriptStack_.clear();
+    abandonCycle_ = true;
+}
+
+void Interpreter::RestartGame()
+{
+    RestoreSnapshot(initialState_);
+    pictureBuffer_.Clear();
+    framebuffer_.Clear();
+    SetFlag(Flag::kRestartCmdExecuted, true);
+    scriptStack_.clear();
+    abandonCycle_ = true;
+}
+
+} // namespace agi
@@ -0,0 +1,141 @@
+#include <agi/startup_loader.h>
+#include <agi/volume_loader.h>
+#include <agi/view_loader.h>
+
+namespace agi {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::chrono::microseconds Elapsed(Clock::time_point since)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - since);
+}
+
+/**
+ * \brief   Waits for all the futures, so that no work is left running if
+ *          one of them failed. The failures are ignored, the resource is
+ *          reported as broken again when it's requested.
+ */
+void WaitAll(std::vector<std::future<void> >& pending)
+{
+    for(auto& future : pending) {
+        future.wait();
+    }
+    for(auto& future : pending) {
+        try {
+            future.get();
+        }
+        catch(std::exception&) {
+            // empty
+        }
+    }
+}
+
+} // namespace
+
+StartupLoader::StartupLoader(
+    const boost::filesystem::path& path,
+    const StartupOptions& options) :
+    options_(options),
+    start_(Clock::now())
+{
+    if (boost::filesystem::is_regular_file(path)) {
+        archive_ = std::make_shared<const GameArchive>(path);
+        stats_.directories = Elapsed(start_);
+        return;
+    }
+
+    const auto logdir = path / "LOGDIR";
+    const auto picdir = path / "PICDIR";
+    const auto viewdir = path / "VIEWDIR";
+
+    if (options_.prefetch) {
+        pool_.reset(new ThreadPool(options_.threads));
+        std::future<void> pending[] = {
+            pool_->Submit([&]() { ParseDirectoryFile(logdir, logics_); }),
+            pool_->Submit([&]() { ParseDirectoryFile(picdir, pictures_); }),
+            pool_->Submit([&]() { ParseDirectoryFile(viewdir, views_); })
+        };
+        // make sure that none of the workers are still writing to the
+        // directories before any exception is propagated
+        for(auto& future : pending) {
+            future.wait();
+        }
+        for(auto& future : pending) {
+            future.get();
+        }
+    }
+    else {
+        ParseDirectoryFile(logdir, logics_);
+        ParseDirectoryFile(picdir, pictures_);
+        ParseDirectoryFile(viewdir, views_);
+    }
+    stats_.directories = Elapsed(start_);
+
+    Collect(logics_);
+    Collect(pictures_);
+    Collect(views_);
+}
+
+void StartupLoader::Collect(const std::vector<DirectoryEntry>& entries)
+{
+    for(auto& entry : entries) {
+        if (!IsMissing(entry)) {
+            referencedVolumes_.set(entry.volume);
+        }
+    }
+}
+
+ResourceIndex StartupLoader::BuildIndex(VolumeLoader& volumes)
+{
+    if (archive_) {
+        return ResourceIndex(archive_);
+    }
+
+    const auto volumeStart = Clock::now();
+    if (options_.prefetch) {
+        // each volume has a slot of its own in the loader, so they can all
+        // be loaded at the same time
+        std::vector<std::future<void> > pending;
+        for(uint8_t i = 0; i < referencedVolumes_.size(); ++i) {
+            if (referencedVolumes_.test(i)) {
+                pending.push_back(pool_->Submit([&volumes, i]() { volumes.GetVolume(i); }));
+            }
+        }
+        // a volume that failed to load makes its entries invalid in the index
+        WaitAll(pending);
+    }
+    ResourceIndex result(volumes, logics_, pictures_, views_);
+    stats_.volumes = Elapsed(volumeStart);
+    return result;
+}
+
+void StartupLoader::Prefetch(const ResourceIndex& resources, ViewLoader& views)
+{
+    if (options_.prefetch) {
+        if (!pool_) {
+            pool_.reset(new ThreadPool(options_.threads));
+        }
+        if (options_.predecodeViews) {
+            // all the volumes are already loaded, so the workers never
+            // modify the volume loader
+            const auto viewStart = Clock::now();
+            std::vector<std::future<void> > pending;
+            for(size_t i = 0; i < 256; ++i) {
+                const auto index = static_cast<uint8_t>(i);
+                if (resources.Contains(ResourceType::kView, index)) {
+                    pending.push_back(pool_->Submit([&views, index]() { views.GetView(index)->Decode(); }));
+                }
+            }
+            WaitAll(pending);
+            stats_.views = Elapsed(viewStart);
+        }
+        // the workers are not needed after the startup
+        pool_.reset();
+    }
+    stats_.total = Elapsed(start_);
+}
+
+} // namespace agi
@@ -0,0 +1,25 @@
+#include <agi/string_arena.h>
+#include <algorithm>
+#include <stdint.h>
+
+namespace agi {
+
+void* StringArena::Allocate(size_t size, size_t alignment)
+{
+    size_t padding = (alignment - (reinterpret_cast<uintptr_t>(current_) % alignment)) % alignment;
+    if ((padding + size) > remaining_) {
+        // a new block, which is larger than usual if the allocation needs it
+        const size_t blockSize = std::max<size_t>(kBlockSize, size + alignment);
+        blocks_.emplace_back(new char[blockSize]);
+        current_ = blocks_.back().get();
+        remaining_ = blockSize;
+        padding = (alignment - (reinterpret_cast<uintptr_t>(current_) % alignment)) % alignment;
+    }
+    char* result = current_ + padding;
+    current_ += padding + size;
+    remaining_ -= padding + size;
+    size_ += size;
+    return result;
+}
+
+} // namespace agi
@@ -0,0 +1,92 @@
+#include <agi/thread_pool.h>
+#include <algorithm>
+
+namespace agi {
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    threads = std::max<size_t>(threads, 1);
+    for(size_t i = 0; i < threads; ++i) {
+        queues_.emplace_back(new Queue());
+    }
+    workers_.reserve(threads);
+    for(size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this, i]() { Run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    for(auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Push(std::function<void()> task)
+{
+    auto& queue = *queues_[next_++ % queues_.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    // a worker counts itself as sleeping before it looks at queued_ for the
+    // last time, so either it sees the task or it's woken here
+    ++queued_;
+    if (sleeping_ > 0) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        condition_.notify_one();
+    }
+}
+
+std::function<void()> ThreadPool::Pop(size_t worker)
+{
+    // an empty function if all the queues are empty
+    for(size_t i = 0; i < queues_.size(); ++i) {
+        auto& queue = *queues_[(worker + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        std::function<void()> task;
+        if (i == 0) {
+            // the newest task in the own queue
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            // steal the oldest task from another queue
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        --queued_;
+        return task;
+    }
+    return nullptr;
+}
+
+void ThreadPool::Run(size_t worker)
+{
+    while(1) {
+        if (auto task = Pop(worker)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++sleeping_;
+        condition_.wait(lock, [this]() { return stop_ || (queued_ > 0); });
+        --sleeping_;
+        if (stop_ && (queued_ == 0)) {
+            // stopped and there is no more work to do
+            return;
+        }
+    }
+}
+
+} // namespace agi
@@ -50,18 +50,17 @@ void ReadFile(const boost::filesystem::path& filename, std::vector<uint8_t>& res
         }
 
         // open file for reading
-        boost::filesystem::ifstream input(filename);
+        boost::filesystem::ifstream input(filename, std::ios::in | std::ios::binary);
         if (!input) {
             throw std::runtime_error("Failed to open file for reading.");
 
         }
-        // disable skipping of whitespace
-        input >> std::noskipws;
 
-        // copy the file
-        result.reserve(size);
-        std::istream_iterator<uint8_t> it(input);
-        std::copy(it, std::istream_iterator<uint8_t>(),std::back_inserter(result));
+        // read the entire file in one go
+        result.resize(size);
+        if (!input.read(reinterpret_cast<char*>(result.data()), size)) {
+            throw std::runtime_error("Failed to read file.");
+        }
     }
     catch(filesystem::filesystem_error&) {
         throw std::runtime_error("Failed to read file.");
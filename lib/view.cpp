@@ -7,15 +7,9 @@
 
 namespace agi {
 
-void SetPixel(uint8_t x, uint8_t y, uint8_t color, Cel& cel)
-{
-    if ((x < cel.width) && (y < cel.height)) {
-        size_t offset = (cel.width * y) + x;
-        cel.pixels[offset] = color;
-    }
-}
+namespace {
 
-void ParseCel(Source& source, Cel& cel)
+void ParseCelHeader(Source& source, Cel& cel)
 {
     uint8_t w = source.GetU8();
     uint8_t h = source.GetU8();
@@ -26,9 +20,11 @@ void ParseCel(Source& source, Cel& cel)
     cel.colorKey = f & 0x0f;
     cel.mirrored = (f >> 7) & 0x01;
     cel.mirrorLoop = (f >> 4) & 0x07;
+}
 
-    cel.pixels.resize(cel.width * cel.height);
-    std::fill(cel.pixels.begin(), cel.pixels.end(), cel.colorKey);
+void DecodeCel(Source& source, const Cel& cel, uint8_t* pixels)
+{
+    std::fill(pixels, pixels + (cel.width * cel.height), cel.colorKey);
 
     size_t x = 0;
     size_t y = 0;
@@ -43,14 +39,17 @@ void ParseCel(Source& source, Cel& cel)
             uint8_t count = (b & 0x0f);
             uint8_t color = (b >> 4);
             for(uint8_t i = 0; i < count; ++i) {
-                SetPixel(x, y, color, cel);
+                // runs that are wider than the cel are clipped
+                if (x < cel.width) {
+                    pixels[(cel.width * y) + x] = color;
+                }
                 ++x;
             }
         }
     }
 }
 
-void ParseLoop(Source& source, Loop& loop)
+void ParseLoop(Source& source, const View& view, Loop& loop, uint16_t& celIndex)
 {
     // position is now v + lofs
     const auto v_plus_lofs = source.GetOffset();
@@ -63,11 +62,79 @@ void ParseLoop(Source& source, Loop& loop)
     // source is now after the loop header
     loop.cels.resize(numCels);
     for(size_t i = 0; i < numCels; ++i) {
+        auto& cel = loop.cels[i];
         source.SetOffset(v_plus_lofs + offsets[i]);
-        ParseCel(source, loop.cels[i]);
+        ParseCelHeader(source, cel);
+        cel.view = &view;
+        cel.index = celIndex++;
+        cel.offset = static_cast<uint32_t>(source.GetOffset());
     }
 }
 
+} // namespace
+
+array_view<uint8_t> View::GetPixels(const Cel& cel) const
+{
+    assert(cel.index < celCount_);
+    const size_t size = cel.width * cel.height;
+    const uint8_t* pixels = pixels_[cel.index].load(std::memory_order_acquire);
+    if (!pixels) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pixels = pixels_[cel.index].load(std::memory_order_relaxed);
+        if (!pixels) {
+            std::unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
+            Source source(data_.data(), data_.size(), cel.offset);
+            DecodeCel(source, cel, buffer.get());
+            pixels = buffer.get();
+            decoded_.push_back(std::move(buffer));
+            decodedSize_ += size;
+            pixels_[cel.index].store(pixels, std::memory_order_release);
+        }
+    }
+    return array_view<uint8_t>(pixels, size);
+}
+
+void View::Decode() const
+{
+    for(auto& loop : loops) {
+        for(auto& cel : loop.cels) {
+            GetPixels(cel);
+        }
+    }
+}
+
+void View::SetData(array_view<uint8_t> data, size_t celCount)
+{
+    data_ = data;
+    celCount_ = celCount;
+    pixels_.reset(new std::atomic<const uint8_t*>[celCount]);
+    for(size_t i = 0; i < celCount; ++i) {
+        pixels_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+void View::SetPixels(const Cel& cel, const uint8_t* pixels)
+{
+    assert(cel.index < celCount_);
+    pixels_[cel.index].store(pixels, std::memory_order_release);
+}
+
+size_t View::GetPixelSize() const
+{
+    // the cels are decoded while the lock is held, so no cel is counted
+    // twice or missed
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t result = decodedSize_;
+    for(auto& loop : loops) {
+        for(auto& cel : loop.cels) {
+            if (!pixels_[cel.index].load(std::memory_order_relaxed)) {
+                result += cel.width * cel.height;
+            }
+        }
+    }
+    return result;
+}
+
 void ParseView(Source& source, View& result)
 {
     // source is now V
@@ -83,12 +150,25 @@ void ParseView(Source& source, View& result)
         offsets[i] = source.GetU16_LE();
     }
 
-    // v + lofs = Loop header
+    // v + lofs = Loop header, only the headers are parsed here
+    uint16_t celCount = 0;
     result.loops.resize(loopCount);
     for(size_t i = 0; i < loopCount; ++i) {
         source.SetOffset(v + offsets[i]);   // v + lofs
-        ParseLoop(source, result.loops[i]);
+        ParseLoop(source, result, result.loops[i], celCount);
+    }
+    result.SetData(array_view<uint8_t>(source.GetBuffer(), source.GetSize()), celCount);
+}
+
+size_t GetMemoryUsage(const View& view)
+{
+    // the cels are charged up front, since they are decoded after the view
+    // has been added to the cache
+    size_t result = sizeof(View) + view.GetPixelSize();
+    for(auto& loop : view.loops) {
+        result += sizeof(Loop) + (loop.cels.capacity() * sizeof(Cel));
     }
+    return result;
 }
 
 void ParseViewResource(Source& source, View& result)
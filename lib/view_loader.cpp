@@ -1,41 +1,87 @@
 #include <agi/view_loader.h>
 #include <agi/source.h>
+#include <chrono>
 
 namespace agi {
 
 ViewLoader::ViewLoader(
-    VolumeLoader& volumes,
-    const boost::filesystem::path& directoryFile) :
-    volumes_(volumes)
+    const ResourceIndex& resources,
+    size_t cacheBudget,
+    std::shared_ptr<ResourceEventSink> events) :
+    resources_(resources),
+    events_(events ? std::move(events) : std::make_shared<NullEventSink>()),
+    reportHits_(events_->WantsHits()),
+    views_(cacheBudget)
 {
-    agi::ParseDirectoryFile(directoryFile, entries_);
+    // empty
 }
 
 std::shared_ptr<View> ViewLoader::GetView(uint8_t index)
 {
-    if (views_[index]) {
-        return views_[index]; // view already loaded
+    std::shared_ptr<View> pView;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pView = views_.Find(index);
+    }
+    if (pView) {
+        // view already loaded
+        if (reportHits_) {
+            events_->OnResourceEvent(ResourceEvent{ResourceType::kView, index, true});
+        }
+        return pView;
     }
 
-    if (index >= entries_.size()) {
-        throw std::invalid_argument(
-            "Invalid view index, no such directory entry.");
+    // the views are decoded without holding the lock, since they are
+    // decoded on several threads when prefetching
+    const auto start = std::chrono::steady_clock::now();
+    auto data = resources_.Get(ResourceType::kView, index);
+    if (auto& archive = resources_.GetArchive()) {
+        // the cels are already decoded in the archive
+        pView = archive->LoadView(index);
     }
-    auto& entry = entries_[index];
-    auto volume = volumes_.GetVolume(entry.volume);
-    if (entry.offset >= volume.size()) {
-        throw std::invalid_argument("Invalid volume offset for view.");
+    else {
+        // create the view instance and parse the data
+        pView = std::make_shared<View>();
+        // create soure
+        Source source(data.data(), data.size());
+        ParseView(source, *pView);
     }
 
-    // create the view instance and parse the data
-    auto pView = std::make_shared<View>();
-    // create soure
-    Source source(volume.data(), volume.size(), entry.offset);
-    ParseViewResource(source, *pView);
+    ResourceEvent event{ResourceType::kView, index, false};
+    event.size = data.size();
+    event.decodeTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    event.data = data;
+    events_->OnResourceEvent(event);
+
     // store the view
-    views_[index] = pView;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto existing = views_.Peek(index)) {
+        // loaded by another thread at the same time
+        return existing;
+    }
+    views_.Insert(index, pView, GetMemoryUsage(*pView));
     // return the loaded view
     return pView;
 }
 
+void ViewLoader::DiscardView(uint8_t index)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    views_.Release(index);
+    views_.Trim();
+}
+
+void ViewLoader::Trim()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    views_.Trim();
+}
+
+CacheStatistics ViewLoader::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return views_.GetStatistics();
+}
+
 } // namespace agi
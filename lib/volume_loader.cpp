@@ -12,25 +12,24 @@ VolumeLoader::VolumeLoader(const boost::filesystem::path& path) :
 
 array_view<uint8_t> VolumeLoader::GetVolume(uint8_t index)
 {
-    if (index > 15) {
+    if (index >= kMaxVolumes) {
         throw std::invalid_argument("Invalid volume index.");
     }
 
-    auto it = volumes_.find(index);
-    if (it != volumes_.end()) {
-        // volume already loaded, so return the data
-        return array_view<uint8_t>(it->second);
+    if (auto& volume = volumes_[index]) {
+        // volume already mapped, so return the data
+        return volume->GetData();
     }
-    // volume not loaded
+    // volume not mapped
     const std::string filename = "VOL." + std::to_string(index);
     auto volPath = path_ / filename;
     if (!boost::filesystem::exists(volPath)) {
         throw std::invalid_argument("The requested volume file does not exist");
     }
-    // load the data
-    ReadFile(volPath, volumes_[index]);
+    // map the data
+    volumes_[index].reset(new MappedFile(volPath));
     // return the data
-    return array_view<uint8_t>(volumes_[index]);
+    return volumes_[index]->GetData();
 }
 
 } // namespace
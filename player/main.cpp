@@ -1,10 +1,18 @@
 #include <agi/interpreter.h>
+#include <agi/frame_telemetry.h>
+#include <agi/cycle_scheduler.h>
 #include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <utility>
+#include <vector>
 #include <SDL.h>
 #include <assert.h>
 
-#define WINDOW_WIDTH (320 * 4)
+#define WINDOW_WIDTH (320 * 2)
 #define WINDOW_HEIGHT (200 * 2)
 
 static uint32_t ColorTable[] = {
@@ -26,36 +34,211 @@ static uint32_t ColorTable[] = {
     0xFFFFFFFF, // white  
 };
 
-void DrawPictureToSurface(
-    SDL_Surface* surface,
-    const uint8_t* pixels,
-    size_t width,
-    size_t height)
+/**
+ * \brief   The arrow keys moves ego, the scancode is what the logics sees
+ */
+agi::KeyEvent TranslateKey(const SDL_Keysym& keySym)
 {
-    SDL_LockSurface(surface);
+    agi::KeyEvent result;
+    switch(keySym.scancode) {
+    case SDL_SCANCODE_LEFT:
+        result.key = agi::Key::kLeft;
+        break;
+    case SDL_SCANCODE_UP:
+        result.key = agi::Key::kUp;
+        break;
+    case SDL_SCANCODE_RIGHT:
+        result.key = agi::Key::kRight;
+        break;
+    case SDL_SCANCODE_DOWN:
+        result.key = agi::Key::kDown;
+        break;
+    default:
+        break;
+    }
+    result.code = static_cast<uint8_t>(keySym.scancode);
+    return result;
+}
 
-    // for each row
-    size_t offset = 0;
-    for(size_t y = 0; y < height; y++) {
-        // get a pointer to the beginning of the line
-        uint32_t* rowp = reinterpret_cast<uint32_t*>(
-            reinterpret_cast<uint8_t*>(surface->pixels) + (y * (surface->pitch)));
-        // for each pixel in the row
-        for(size_t x = 0; x < width; ++x) {
-            *rowp++ = ColorTable[pixels[offset++] & 0x0F];
+/**
+ * \brief   Locks the rows of a streaming texture, only the locked rows are
+ *          uploaded. Returns nullptr if the texture can't be locked.
+ */
+uint32_t* LockRows(
+    SDL_Texture* texture,
+    int width,
+    const agi::Framebuffer::DirtyRows& rows,
+    size_t& pitch)
+{
+    SDL_Rect rect;
+    rect.x = 0;
+    rect.y = static_cast<int>(rows.top);
+    rect.w = width;
+    rect.h = static_cast<int>(rows.bottom - rows.top);
+    void* pixels = nullptr;
+    int bytes = 0;
+    if (SDL_LockTexture(texture, &rect, &pixels, &bytes) != 0) {
+        return nullptr;
+    }
+    pitch = bytes / sizeof(uint32_t);
+    return static_cast<uint32_t*>(pixels);
+}
+
+/**
+ * \brief   Converts the rows of the priority screen, the first row is
+ *          written to the start of the pixels.
+ */
+void ConvertPriority(
+    uint32_t* pixels,
+    size_t pitch,
+    const agi::Framebuffer& framebuffer,
+    const agi::Framebuffer::DirtyRows& rows)
+{
+    const uint8_t* priority = framebuffer.GetPriorityBuffer().data();
+    for(size_t y = rows.top; y < rows.bottom; ++y) {
+        uint32_t* row = pixels + ((y - rows.top) * pitch);
+        const uint8_t* source = priority + (y * agi::Framebuffer::kWidth);
+        for(size_t x = 0; x < agi::Framebuffer::kWidth; ++x) {
+            row[x] = ColorTable[source[x] & 0x0F];
         }
     }
-    SDL_UnlockSurface(surface);
+}
+
+enum {
+    kHudInterval = 30,          // the number of frames between updates of the HUD
+    kHistogramBuckets = 20,
+    kHistogramWidth = 2000      // microseconds per bucket
+};
+
+// the shortest cycle period, which is also how long a frame in turbo runs
+static const std::chrono::milliseconds kFrameTime(16);
+// in turbo the cycles are run in batches until a frame's worth of time is used
+static const size_t kTurboCycles = 10;
+
+/**
+ * \brief   Writes the percentiles of every phase into the HUD, in
+ *          microseconds, and returns the histogram of the frame times.
+ */
+std::vector<size_t> UpdateHud(const agi::FrameTelemetry& telemetry, agi::Framebuffer& hud)
+{
+    const auto frames = telemetry.GetFrames();
+    hud.ClearLines(0, 24, agi::kBlack);
+    char line[41];
+    std::snprintf(line, sizeof(line), "%-8s %6s %6s %6s %6s", "us", "p50", "p90", "p99", "max");
+    hud.Display(0, 0, line);
+    for(size_t i = 0; i <= agi::kFramePhases; ++i) {
+        const auto phase = static_cast<agi::FramePhase>(i);
+        const auto statistics = agi::GetFrameStatistics(frames, phase);
+        std::snprintf(line, sizeof(line), "%-8s %6u %6u %6u %6u",
+            agi::GetFramePhaseName(phase),
+            statistics.p50, statistics.p90, statistics.p99, statistics.max);
+        hud.Display(static_cast<uint8_t>(i + 1), 0, line);
+    }
+    std::snprintf(line, sizeof(line), "%zu frames, %u ms per bar",
+        frames.size(), static_cast<unsigned>(kHistogramWidth / 1000));
+    hud.Display(static_cast<uint8_t>(agi::kFramePhases + 2), 0, line);
+    return agi::GetFrameHistogram(frames, kHistogramWidth, kHistogramBuckets);
+}
+
+/**
+ * \brief   Draws the histogram of the frame times as bars along the bottom
+ *          of the area
+ */
+void DrawHistogram(SDL_Renderer* renderer, const std::vector<size_t>& histogram, const SDL_Rect& area)
+{
+    const size_t highest = histogram.empty() ? 0 : *std::max_element(histogram.begin(), histogram.end());
+    if (!highest) {
+        return;
+    }
+    const int width = area.w / static_cast<int>(histogram.size());
+    const int height = area.h / 3;
+    SDL_SetRenderDrawColor(renderer, 0x55, 0xFF, 0x55, 0xFF);
+    for(size_t i = 0; i < histogram.size(); ++i) {
+        SDL_Rect bar;
+        bar.h = static_cast<int>((histogram[i] * height) / highest);
+        bar.w = width - 2;
+        bar.x = area.x + (static_cast<int>(i) * width) + 1;
+        bar.y = area.y + area.h - bar.h;
+        SDL_RenderFillRect(renderer, &bar);
+    }
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xFF);
 }
 
 int main(int argc, char** argv)
 {
     if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " directory [--prefetch] [--predecode-views] [--view-cache kilobytes] [--picture-cache kilobytes] [--resource-stats] [--dump-logics directory] [--profile name] [--hud] [--frame-log file] [--turbo] [--priority]" << std::endl;
         return -1;
     }
 
+    agi::InterpreterOptions options;
+    std::shared_ptr<agi::CountingEventSink> resourceCounters;
+    std::vector<std::shared_ptr<agi::ResourceEventSink>> eventSinks;
+    std::string profile;
+    bool showHud = false;
+    std::string frameLog;
+    bool turbo = false;
+    bool showPriority = false;
+    for(int i = 2; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        if (arg == "--prefetch") {
+            options.startup.prefetch = true;
+        }
+        else if (arg == "--predecode-views") {
+            options.startup.prefetch = true;
+            options.startup.predecodeViews = true;
+        }
+        else if ((arg == "--view-cache") && ((i + 1) < argc)) {
+            options.viewCacheBudget = std::stoul(argv[++i]) * 1024;
+        }
+        else if ((arg == "--picture-cache") && ((i + 1) < argc)) {
+            options.pictureCacheBudget = std::stoul(argv[++i]) * 1024;
+        }
+        else if (arg == "--resource-stats") {
+            resourceCounters = std::make_shared<agi::CountingEventSink>();
+            eventSinks.push_back(resourceCounters);
+        }
+        else if ((arg == "--dump-logics") && ((i + 1) < argc)) {
+            eventSinks.push_back(std::make_shared<agi::DumpEventSink>(argv[++i]));
+        }
+        else if ((arg == "--profile") && ((i + 1) < argc)) {
+            profile = argv[++i];
+            if (!agi::kProfilerEnabled) {
+                std::cerr << "Built without AGI_ENABLE_PROFILER, the profile will be empty." << std::endl;
+            }
+            options.profiler = std::make_shared<agi::Profiler>();
+        }
+        else if (arg == "--hud") {
+            showHud = true;
+        }
+        else if ((arg == "--frame-log") && ((i + 1) < argc)) {
+            frameLog = argv[++i];
+        }
+        else if (arg == "--turbo") {
+            turbo = true;
+        }
+        else if (arg == "--priority") {
+            showPriority = true;
+        }
+    }
+    // the counters and the dump can be asked for together
+    if (eventSinks.size() == 1) {
+        options.events = eventSinks.front();
+    }
+    else if (eventSinks.size() > 1) {
+        options.events = std::make_shared<agi::FanOutEventSink>(std::move(eventSinks));
+    }
+    // the time of the logics and of painting the scene are reported apart
+    options.timeFinishCycle = true;
+
     const boost::filesystem::path path(argv[1]);
-    agi::Interpreter interpreter(path);
+    agi::Interpreter interpreter(path, options);
+
+    const auto& stats = interpreter.GetStartupStats();
+    std::cout << "Startup: directories " << stats.directories.count() << " us, "
+        << "volumes " << stats.volumes.count() << " us, "
+        << "views " << stats.views.count() << " us, "
+        << "total " << stats.total.count() << " us" << std::endl;
 
 
     SDL_Init(SDL_INIT_VIDEO);
@@ -64,7 +247,7 @@ int main(int argc, char** argv)
         "AGI",                             // window title
         SDL_WINDOWPOS_UNDEFINED,           // initial x position
         SDL_WINDOWPOS_UNDEFINED,           // initial y position
-        WINDOW_WIDTH,                      // width, in pixels
+        showPriority ? (WINDOW_WIDTH * 2) : WINDOW_WIDTH,  // width, in pixels
         WINDOW_HEIGHT,                     // height, in pixels
         SDL_WINDOW_OPENGL                  // flags - see below
     );    
@@ -83,88 +266,256 @@ int main(int argc, char** argv)
         return -1;
     }
 
-    Uint32 rmask, gmask, bmask, amask;
-
-    /* SDL interprets each pixel as a 32-bit number, so our masks must depend
-       on the endianness (byte order) of the machine */
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-    rmask = 0xff000000;
-    gmask = 0x00ff0000;
-    bmask = 0x0000ff00;
-    amask = 0x000000ff;
-#else
-    rmask = 0x000000ff;
-    gmask = 0x0000ff00;
-    bmask = 0x00ff0000;
-    amask = 0xff000000;
-#endif
-
-        // create a texture
-    SDL_Texture* fbTexture = nullptr;
-    SDL_Texture* priorityTexture = nullptr;
+    // the textures are created once and the changed rows are converted
+    // straight into them
+    SDL_Texture* fbTexture = SDL_CreateTexture(
+        renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, 320, 200);
+    SDL_Texture* priorityTexture = SDL_CreateTexture(
+        renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, 160, 200);
+    // the HUD is drawn with the font of the interpreter, black is transparent
+    SDL_Texture* hudTexture = SDL_CreateTexture(
+        renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, 320, 200);
+    if (!fbTexture || !priorityTexture || !hudTexture) {
+        std::cerr << "Failed to create SDL textures: " << SDL_GetError() << std::endl;
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return -1;
+    }
+    SDL_SetTextureBlendMode(hudTexture, SDL_BLENDMODE_BLEND);
+    uint32_t hudColors[16];
+    std::copy(std::begin(ColorTable), std::end(ColorTable), hudColors);
+    hudColors[agi::kBlack] = 0;
+    agi::Framebuffer hud;
+    bool hudDrawn = false;
+    std::vector<size_t> histogram;
+    // the priority texture isn't updated while it's hidden
+    bool priorityStale = true;
 
-    SDL_Surface* framebuffer = SDL_CreateRGBSurface(0, 320, 200, 32, rmask, gmask, bmask, amask);
-    assert(framebuffer);
-    SDL_Surface* prioritySurface = SDL_CreateRGBSurface(0, 160, 200, 32, rmask, gmask, bmask, amask);
-    assert(prioritySurface);
+    typedef std::chrono::steady_clock Clock;
+    auto elapsed = [](Clock::time_point start, Clock::time_point end) {
+        return static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+    };
+    agi::FrameTelemetry telemetry;
+    agi::CycleScheduler scheduler;
+    SDL_SetWindowTitle(window, turbo ? "AGI (turbo)" : "AGI");
 
     SDL_Event e;
     bool quit = false;
+    // the window is only redrawn when something on it has changed
+    bool redraw = true;
     while (!quit){
         while (SDL_PollEvent(&e)){
             if (e.type == SDL_QUIT){
                 quit = true;
             }
 
+            if ((e.type == SDL_WINDOWEVENT) && (e.window.event == SDL_WINDOWEVENT_EXPOSED)) {
+                redraw = true;
+            }
+
             if (e.type == SDL_KEYDOWN){
-                interpreter.OnKeyPress(e.key.keysym);
+                if (e.key.keysym.sym == SDLK_F1) {
+                    // toggles the HUD, the logics never sees the key
+                    showHud = !showHud;
+                    redraw = true;
+                    continue;
+                }
+                if (e.key.keysym.sym == SDLK_F3) {
+                    // toggles the priority screen, next to the picture
+                    showPriority = !showPriority;
+                    SDL_SetWindowSize(window, showPriority ? (WINDOW_WIDTH * 2) : WINDOW_WIDTH, WINDOW_HEIGHT);
+                    redraw = true;
+                    continue;
+                }
+                if (e.key.keysym.sym == SDLK_F2) {
+                    // toggles turbo, the schedule restarts when it's turned off
+                    turbo = !turbo;
+                    scheduler.Reset(Clock::now());
+                    SDL_SetWindowTitle(window, turbo ? "AGI (turbo)" : "AGI");
+                    continue;
+                }
+                interpreter.OnKeyPress(TranslateKey(e.key.keysym));
             }
         }
 
-        auto uar = interpreter.StartCycle();
-        if (uar) {
-            assert(false);
+        agi::FrameTimings timings;
+        const auto cycleStart = Clock::now();
+        if (turbo) {
+            // runs as many cycles as fits in a frame, only the last is painted
+            const auto frameEnd = cycleStart + kFrameTime;
+            do {
+                if (interpreter.RunCycles(kTurboCycles) != kTurboCycles) {
+                    assert(false);
+                }
+            } while(Clock::now() < frameEnd);
+        }
+        else {
+            // a delay of zero runs a cycle per frame, an idle screen isn't
+            // presented so the vertical sync can't be what limits the speed
+            const auto period = std::max(
+                std::chrono::milliseconds(interpreter.GetCycleDelay()), kFrameTime);
+            const size_t cycles = scheduler.GetDueCycles(cycleStart, period);
+            if (!cycles) {
+                // nothing to present until the next cycle, which is due at
+                // a fixed time so sleeping too long doesn't add up
+                const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    scheduler.GetNextCycle() - cycleStart);
+                SDL_Delay(std::max<Uint32>(static_cast<Uint32>(wait.count()), 1));
+                continue;
+            }
+            // cycles that are late are run back to back and only the last
+            // is painted and presented
+            if (interpreter.RunCycles(cycles) != cycles) {
+                assert(false);
+            }
         }
+        const auto cycleEnd = Clock::now();
+        const uint32_t total = elapsed(cycleStart, cycleEnd);
+        const uint32_t finish = std::min(
+            static_cast<uint32_t>(interpreter.GetFinishCycleTime().count()), total);
+        timings[agi::FramePhase::kCycle] = total - finish;
+        timings[agi::FramePhase::kFinishCycle] = finish;
 
-        // get the framebuffer
+        // only the rows that changed since the last frame are converted,
+        // straight into the locked rows of the textures, and an idle screen
+        // isn't redrawn at all
         auto& fb = interpreter.GetFramebuffer();
-        DrawPictureToSurface(framebuffer, fb.GetPictureBuffer().data(), 320, 200);
-        DrawPictureToSurface(prioritySurface, fb.GetPriorityBuffer().data(), 160, 200);
+        const auto dirty = fb.TakeDirtyRows();
+        agi::Framebuffer::DirtyRows priorityRows;
+        if (showPriority) {
+            if (priorityStale) {
+                priorityRows.Add(0, agi::Framebuffer::kHeight);
+                priorityStale = false;
+            }
+            priorityRows.Add(dirty);
+        }
+        else if (!dirty.IsEmpty()) {
+            priorityStale = true;
+        }
+        const bool updateHud = showHud && ((telemetry.GetFrameCount() % kHudInterval) == 0);
+        agi::Framebuffer::DirtyRows hudRows;
+        if (updateHud) {
+            histogram = UpdateHud(telemetry, hud);
+            hudRows = hud.TakeDirtyRows();
+        }
 
-        if (fbTexture) {
-            SDL_DestroyTexture(fbTexture);
+        size_t pitch = 0;
+        bool fbLocked = false;
+        if (!dirty.IsEmpty()) {
+            if (uint32_t* pixels = LockRows(fbTexture, 320, dirty, pitch)) {
+                fb.Convert(pixels, pitch, ColorTable, dirty);
+                fbLocked = true;
+            }
+        }
+        bool priorityLocked = false;
+        if (!priorityRows.IsEmpty()) {
+            if (uint32_t* pixels = LockRows(priorityTexture, 160, priorityRows, pitch)) {
+                ConvertPriority(pixels, pitch, fb, priorityRows);
+                priorityLocked = true;
+            }
+        }
+        bool hudLocked = false;
+        if (!hudRows.IsEmpty()) {
+            if (uint32_t* pixels = LockRows(hudTexture, 320, hudRows, pitch)) {
+                hud.Convert(pixels, pitch, hudColors, hudRows);
+                hudLocked = true;
+                hudDrawn = true;
+            }
         }
-        fbTexture = SDL_CreateTextureFromSurface(renderer, framebuffer);
-        if (priorityTexture) {
-            SDL_DestroyTexture(priorityTexture);
+        const auto convertEnd = Clock::now();
+        timings[agi::FramePhase::kConvert] = elapsed(cycleEnd, convertEnd);
 
+        // the locked rows are uploaded when the textures are unlocked
+        if (fbLocked) {
+            SDL_UnlockTexture(fbTexture);
+        }
+        if (priorityLocked) {
+            SDL_UnlockTexture(priorityTexture);
         }
-        priorityTexture = SDL_CreateTextureFromSurface(renderer, prioritySurface);
+        if (hudLocked) {
+            SDL_UnlockTexture(hudTexture);
+        }
+        const auto uploadEnd = Clock::now();
+        timings[agi::FramePhase::kUpload] = elapsed(convertEnd, uploadEnd);
+
+        if (redraw || !dirty.IsEmpty() || updateHud) {
+            redraw = false;
 
-        SDL_Rect fbRect;
-        fbRect.x = 0;
-        fbRect.y = 0;
-        fbRect.w = 640;
-        fbRect.h = 400;
+            SDL_Rect fbRect;
+            fbRect.x = 0;
+            fbRect.y = 0;
+            fbRect.w = 640;
+            fbRect.h = 400;
 
-        SDL_Rect pRect;
-        pRect.x = 640;
-        pRect.y = 0;
-        pRect.w = 640;
-        pRect.h = 400;
+            SDL_Rect pRect;
+            pRect.x = 640;
+            pRect.y = 0;
+            pRect.w = 640;
+            pRect.h = 400;
 
-        SDL_RenderClear(renderer);
-        if (fbTexture) {
+            SDL_RenderClear(renderer);
             SDL_RenderCopy(renderer, fbTexture, nullptr, &fbRect);
+            if (showPriority) {
+                SDL_RenderCopy(renderer, priorityTexture, nullptr, &pRect);
+            }
+            if (showHud && hudDrawn) {
+                SDL_RenderCopy(renderer, hudTexture, nullptr, &fbRect);
+                DrawHistogram(renderer, histogram, fbRect);
+            }
+            // waits for the vertical sync, which is included in the present time
+            SDL_RenderPresent(renderer);
         }
-        if (priorityTexture) {
-            SDL_RenderCopy(renderer, priorityTexture, nullptr, &pRect);
+        timings[agi::FramePhase::kPresent] = elapsed(uploadEnd, Clock::now());
+        telemetry.Push(timings);
+    }
+
+    const auto frames = telemetry.GetFrames();
+    const auto frameTimes = agi::GetFrameStatistics(frames, agi::FramePhase::kMax);
+    std::cout << "Frames: " << frames.size() << ", p50 " << frameTimes.p50 << " us, "
+        << "p90 " << frameTimes.p90 << " us, "
+        << "p99 " << frameTimes.p99 << " us, "
+        << "max " << frameTimes.max << " us" << std::endl;
+    std::cout << "Skipped cycles: " << scheduler.GetSkippedCycles() << std::endl;
+    if (!frameLog.empty()) {
+        boost::filesystem::ofstream out(frameLog);
+        agi::WriteFrameCsv(out, frames);
+    }
+
+    const auto viewCache = interpreter.GetViewCacheStatistics();
+    std::cout << "View cache: " << viewCache.hits << " hits, "
+        << viewCache.misses << " misses, "
+        << viewCache.evictions << " evictions, "
+        << viewCache.size << " bytes" << std::endl;
+    const auto pictureCache = interpreter.GetPictureCacheStatistics();
+    std::cout << "Picture cache: " << pictureCache.hits << " hits, "
+        << pictureCache.misses << " misses, "
+        << pictureCache.evictions << " evictions, "
+        << pictureCache.size << " bytes" << std::endl;
+    if (resourceCounters) {
+        const char* names[] = {"Logics", "Pictures", "Views"};
+        for(size_t type = 0; type < agi::kResourceTypes; ++type) {
+            const auto counters = resourceCounters->GetCounters(static_cast<agi::ResourceType>(type));
+            std::cout << names[type] << ": " << counters.hits << " hits, "
+                << counters.misses << " loads, "
+                << counters.bytes << " bytes, "
+                << counters.decodeTime.count() << " us" << std::endl;
         }
-        SDL_RenderPresent(renderer);
+    }
 
-        SDL_Delay(interpreter.GetCycleDelay());
+    if (options.profiler) {
+        boost::filesystem::ofstream report(profile + ".txt");
+        options.profiler->WriteReport(report);
+        boost::filesystem::ofstream csv(profile + ".csv");
+        options.profiler->WriteCsv(csv);
     }
 
+    SDL_DestroyTexture(hudTexture);
+    SDL_DestroyTexture(priorityTexture);
+    SDL_DestroyTexture(fbTexture);
+    SDL_DestroyRenderer(renderer);
+
     // Close and destroy the window
     SDL_DestroyWindow(window);
 
@@ -0,0 +1,191 @@
+#include <agi/picture.h>
+#include <agi/source.h>
+#include <array>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Draws seeded random picture command streams and compares the hashes of
+ * the picture and the priority screen with the hashes of a known good
+ * build. The streams only use the drawing commands, so no game is needed.
+ */
+namespace {
+
+enum class Stream {
+    kLines,     // absolute and relative lines
+    kCorners,   // x and y corners
+    kFills      // outlines that are filled
+};
+
+struct Golden
+{
+    Stream stream;
+    uint32_t seed;
+    uint64_t picture;
+    uint64_t priority;
+};
+
+const Golden kGolden[] = {
+    {Stream::kLines,    1, 0x0c98efff828e291bull, 0xa6e2adce8f371f13ull},
+    {Stream::kLines,    2, 0x3ab61050d2c44eddull, 0xc2fc617e419db978ull},
+    {Stream::kCorners,  1, 0x99808859c6ebe38dull, 0x21f127e2bce019b7ull},
+    {Stream::kCorners,  2, 0x2a7ffb9df04f1c03ull, 0x98e9f0ec93da5704ull},
+    {Stream::kFills,    1, 0xa3a30bb502a50783ull, 0x3eb73754b193c3c3ull},
+    {Stream::kFills,    2, 0xf734dccd34c96d1full, 0x4b5b494ece4f21ebull},
+};
+
+const size_t kPictures = 200;       // pictures per stream
+const size_t kCommands = 40;        // drawing commands per picture
+
+uint64_t Hash(const uint8_t* data, size_t size, uint64_t hash)
+{
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * \brief   A coordinate, now and then outside of the screen to exercise
+ *          the clipping
+ */
+uint8_t Coordinate(std::mt19937& random, uint32_t limit)
+{
+    if ((random() % 50) == 0) {
+        return static_cast<uint8_t>(160 + (random() % 80));
+    }
+    return static_cast<uint8_t>(random() % limit);
+}
+
+std::vector<uint8_t> MakePicture(Stream stream, std::mt19937& random)
+{
+    std::vector<uint8_t> data;
+    bool pictureDraw = true;
+    for(size_t i = 0; i < kCommands; ++i) {
+        // the colors are changed now and then, also disabling the planes
+        switch(random() % 6) {
+        case 0:
+            data.push_back(0xf0);
+            data.push_back(static_cast<uint8_t>(random() % 16));
+            pictureDraw = true;
+            continue;
+        case 1:
+            data.push_back(0xf2);
+            data.push_back(static_cast<uint8_t>(random() % 16));
+            continue;
+        case 2:
+            if ((random() % 4) == 0) {
+                data.push_back(0xf1);
+                pictureDraw = false;
+            }
+            else if ((random() % 4) == 0) {
+                data.push_back(0xf3);
+            }
+            continue;
+        default:
+            break;
+        }
+        const size_t points = 1 + (random() % 8);
+        switch(stream) {
+        case Stream::kLines:
+            if (random() % 2) {
+                data.push_back(0xf6);
+                for(size_t j = 0; j <= points; ++j) {
+                    data.push_back(Coordinate(random, 160));
+                    data.push_back(Coordinate(random, 168));
+                }
+            }
+            else {
+                data.push_back(0xf7);
+                data.push_back(Coordinate(random, 160));
+                data.push_back(Coordinate(random, 168));
+                for(size_t j = 0; j < points; ++j) {
+                    uint8_t delta;
+                    do {
+                        delta = static_cast<uint8_t>(random());
+                    } while(delta >= 0xf0);
+                    data.push_back(delta);
+                }
+            }
+            break;
+        case Stream::kCorners:
+            data.push_back((random() % 2) ? 0xf4 : 0xf5);
+            data.push_back(Coordinate(random, 160));
+            data.push_back(Coordinate(random, 168));
+            for(size_t j = 0; j < points; ++j) {
+                data.push_back((j % 2) ? Coordinate(random, 168) : Coordinate(random, 160));
+            }
+            break;
+        case Stream::kFills:
+            if (pictureDraw && ((random() % 2) == 0)) {
+                data.push_back(0xf8);
+                for(size_t j = 0; j < points; ++j) {
+                    data.push_back(Coordinate(random, 160));
+                    data.push_back(Coordinate(random, 168));
+                }
+            }
+            else {
+                data.push_back(0xf6);
+                for(size_t j = 0; j <= points; ++j) {
+                    data.push_back(Coordinate(random, 160));
+                    data.push_back(Coordinate(random, 168));
+                }
+            }
+            break;
+        }
+    }
+    data.push_back(0xff);
+    return data;
+}
+
+const char* GetStreamName(Stream stream)
+{
+    switch(stream) {
+    case Stream::kLines:
+        return "lines";
+    case Stream::kCorners:
+        return "corners";
+    default:
+        return "fills";
+    }
+}
+
+} // namespace
+
+int main()
+{
+    int failures = 0;
+    for(auto& golden : kGolden) {
+        std::mt19937 random(golden.seed);
+        uint64_t picture = 14695981039346656037ull;
+        uint64_t priority = 14695981039346656037ull;
+        for(size_t i = 0; i < kPictures; ++i) {
+            const auto data = MakePicture(golden.stream, random);
+            agi::Framebuffer framebuffer;
+            agi::Source source(data.data(), data.size(), 0);
+            agi::DrawPicture(source, framebuffer);
+            // the picture is hashed as it's presented, with the pixels
+            // doubled, and with the palette indices as the pixels
+            const uint8_t palette[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+            std::array<uint8_t, agi::Framebuffer::kPixelPitch * agi::Framebuffer::kHeight> pixels;
+            framebuffer.Convert(pixels.data(), agi::Framebuffer::kPixelPitch, palette);
+            const auto& priorities = framebuffer.GetPriorityBuffer();
+            picture = Hash(pixels.data(), pixels.size(), picture);
+            priority = Hash(priorities.data(), priorities.size(), priority);
+        }
+        const bool passed = (picture == golden.picture) && (priority == golden.priority);
+        std::printf("%s %-7s seed %u: picture %016llx priority %016llx\n",
+            passed ? "ok  " : "FAIL",
+            GetStreamName(golden.stream),
+            golden.seed,
+            static_cast<unsigned long long>(picture),
+            static_cast<unsigned long long>(priority));
+        if (!passed) {
+            ++failures;
+        }
+    }
+    return failures ? 1 : 0;
+}
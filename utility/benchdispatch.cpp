@@ -0,0 +1,151 @@
+#include <agi/interpreter.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+
+using agi::ActionCommand;
+
+// commands that only change the variables, the flags and the objects, so
+// they can run any number of times outside of a logic
+const ActionCommand kCommands[] = {
+    ActionCommand::kIncrement,
+    ActionCommand::kDecrement,
+    ActionCommand::kAssignN,
+    ActionCommand::kAssignV,
+    ActionCommand::kAddN,
+    ActionCommand::kAddV,
+    ActionCommand::kSubN,
+    ActionCommand::kSubV,
+    ActionCommand::kLIndirectN,
+    ActionCommand::kRIndirect,
+    ActionCommand::kSet,
+    ActionCommand::kReset,
+    ActionCommand::kToggle,
+    ActionCommand::kSetV,
+    ActionCommand::kRandom,
+    ActionCommand::kPosition,
+    ActionCommand::kPositionV,
+    ActionCommand::kFixLoop,
+    ActionCommand::kReleaseLoop,
+    ActionCommand::kSetPriority,
+    ActionCommand::kReleasePriority,
+    ActionCommand::kCurrentView,
+    ActionCommand::kNormalCycle,
+    ActionCommand::kCycleTime,
+    ActionCommand::kStopUpdate,
+    ActionCommand::kStartUpdate,
+    ActionCommand::kIgnoreHorizon,
+    ActionCommand::kSetHorizon,
+    ActionCommand::kObjectOnWater,
+    ActionCommand::kObjectOnLand,
+    ActionCommand::kObserveObjects,
+    ActionCommand::kStepSize,
+    ActionCommand::kStepTime,
+    ActionCommand::kProgramControl,
+    ActionCommand::kPlayerControl,
+    // the categories without handlers of their own
+    ActionCommand::kLoadSound,
+    ActionCommand::kStatusLineOn,
+    ActionCommand::kSetKey
+};
+
+agi::Instruction MakeCommand(ActionCommand command, std::mt19937& random)
+{
+    agi::Instruction result = {};
+    result.kind = agi::Instruction::kCommand;
+    result.command = static_cast<uint8_t>(command);
+    // the first arguments are objects, a random number needs a range
+    result.arguments[0] = static_cast<uint8_t>(random() % 16);
+    for(size_t i = 1; i < agi::Instruction::kMaxArguments; ++i) {
+        result.arguments[i] = static_cast<uint8_t>(1 + (random() % 200));
+    }
+    return result;
+}
+
+/**
+ * \brief   Executes the commands a number of times, returns the number of
+ *          nanoseconds per command.
+ */
+double Run(
+    agi::Interpreter& interpreter,
+    const std::vector<agi::Instruction>& commands,
+    agi::CommandDispatch dispatch,
+    size_t repeat)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < repeat; ++i) {
+        interpreter.ExecuteCommands(commands, dispatch);
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (commands.size() * repeat);
+}
+
+/**
+ * \brief   Runs the commands with both dispatchers, alternating a few times
+ *          so that neither of them gets a warmer cache. Returns the best
+ *          time of each.
+ */
+std::pair<double, double> Compare(
+    agi::Interpreter& interpreter,
+    const std::vector<agi::Instruction>& commands,
+    size_t repeat)
+{
+    double table = 1e9, switched = 1e9;
+    for(int i = 0; i < 5; ++i) {
+        table = std::min(table, Run(interpreter, commands, agi::CommandDispatch::kTable, repeat));
+        switched = std::min(switched, Run(interpreter, commands, agi::CommandDispatch::kSwitch, repeat));
+    }
+    return std::make_pair(table, switched);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <game directory or archive> [repeat]" << std::endl;
+        return -1;
+    }
+
+    const size_t repeat = (argc > 2) ? std::stoul(argv[2]) : 1000;
+    try {
+        agi::Interpreter interpreter(argv[1]);
+        std::mt19937 random(1);
+        const size_t kCount = sizeof(kCommands) / sizeof(kCommands[0]);
+
+        // the commands in a random order, like in a logic
+        std::vector<agi::Instruction> mixed;
+        for(size_t i = 0; i < 4096; ++i) {
+            mixed.push_back(MakeCommand(kCommands[random() % kCount], random));
+        }
+        const auto total = Compare(interpreter, mixed, repeat);
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Mixed commands:  table " << total.first << " ns, switch "
+            << total.second << " ns" << std::endl;
+
+        // every command on its own, which is as easy as it gets for the
+        // branch predictor
+        std::cout << std::endl << std::left << std::setw(20) << "Command"
+            << std::right << std::setw(6) << "Table" << " " << std::setw(8) << "Switch" << std::endl;
+        for(auto command : kCommands) {
+            std::vector<agi::Instruction> same;
+            for(size_t i = 0; i < 1024; ++i) {
+                same.push_back(MakeCommand(command, random));
+            }
+            const auto times = Compare(interpreter, same, repeat);
+            std::cout << std::left << std::setw(20) << agi::GetCommandName(static_cast<uint8_t>(command))
+                << std::right << std::setw(6) << times.first << " "
+                << std::setw(8) << times.second << std::endl;
+        }
+    }
+    catch(std::exception& e) {
+        std::cerr << "Caught exception: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include <agi/archive.h>
+#include <agi/commands.h>
+#include <agi/native_module.h>
+#include <agi/resource_index.h>
+#include <agi/script_loader.h>
+#include <agi/volume_loader.h>
+#include <boost/filesystem/fstream.hpp>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+namespace {
+
+std::string Hex(unsigned value)
+{
+    std::stringstream ss;
+    ss << "0x" << std::hex << std::setw(2) << std::setfill('0') << value;
+    return ss.str();
+}
+
+std::string TestExpression(const agi::Condition& condition)
+{
+    std::stringstream ss;
+    ss << (condition.negate ? "!" : "") << "context.Test(" << Hex(condition.test);
+    const size_t argc = agi::IsConditionValid(condition.test) ?
+        agi::GetNumberOfConditionArguments(condition.test) : 0;
+    for(size_t i = 0; i < argc; ++i) {
+        ss << ", " << unsigned(condition.arguments[i]);
+    }
+    ss << ")";
+    return ss.str();
+}
+
+/**
+ * \brief   The conditions of an if as a C++ expression, which is evaluated
+ *          in the same order and short-circuited like EvaluateConditions.
+ */
+std::string ConditionExpression(const agi::Script& script, const agi::Instruction& instruction)
+{
+    std::vector<std::string> terms;
+    const agi::Condition* condition = script.conditions.data() + instruction.condition;
+    const agi::Condition* end = condition + instruction.conditionCount;
+    while(condition != end) {
+        if (condition->test == agi::Condition::kOr) {
+            std::string group;
+            for(size_t i = 1; i <= condition->count; ++i) {
+                group += (group.empty() ? "" : " || ") + TestExpression(condition[i]);
+            }
+            if (group.empty()) {
+                group = "false";
+            }
+            terms.push_back((condition->negate ? "!(" : "(") + group + ")");
+            condition += condition->count + 1;
+        }
+        else {
+            terms.push_back(TestExpression(*condition));
+            ++condition;
+        }
+    }
+    if (terms.empty()) {
+        return "true";
+    }
+    std::string result;
+    for(auto& term : terms) {
+        result += (result.empty() ? "" : " && ") + term;
+    }
+    return result;
+}
+
+void WriteLogic(std::ostream& out, unsigned index, const agi::Script& script)
+{
+    const auto& instructions = script.instructions;
+    const size_t count = instructions.size();
+
+    // the instructions that the logic can continue from, and the jump targets
+    std::set<size_t> resume = {0};
+    std::set<size_t> labels = {0, count};
+    for(size_t i = 0; i < count; ++i) {
+        const auto& instruction = instructions[i];
+        if (instruction.kind == agi::Instruction::kCommand) {
+            resume.insert(i + 1);
+            labels.insert(i + 1);
+        }
+        else if ((instruction.kind == agi::Instruction::kIf) ||
+                 (instruction.kind == agi::Instruction::kGoto)) {
+            labels.insert(instruction.target);
+        }
+    }
+
+    out << "void Logic" << index << "(agi::NativeContext& context, size_t& ip)\n{\n";
+    out << "    switch(ip) {\n";
+    for(auto i : resume) {
+        if (i < count) {
+            out << "    case " << i << ": goto i" << i << ";\n";
+        }
+    }
+    out << "    default: goto i" << count << ";\n";
+    out << "    }\n";
+
+    for(size_t i = 0; i < count; ++i) {
+        const auto& instruction = instructions[i];
+        if (labels.count(i)) {
+            out << "i" << i << ":\n";
+        }
+        switch(instruction.kind) {
+        case agi::Instruction::kCommand:
+            {
+                const size_t argc = agi::GetNumberOfArguments(instruction.command);
+                out << "    // " << agi::GetCommandName(instruction.command) << "\n";
+                out << "    ip = " << (i + 1) << ";\n";
+                out << "    {\n";
+                if (argc) {
+                    out << "        static const uint8_t arguments[] = {";
+                    for(size_t a = 0; a < argc; ++a) {
+                        out << (a ? ", " : "") << unsigned(instruction.arguments[a]);
+                    }
+                    out << "};\n";
+                }
+                out << "        if (!context.Command(" << Hex(instruction.command) << ", "
+                    << (argc ? "arguments" : "nullptr") << ")) {\n";
+                out << "            return;\n";
+                out << "        }\n";
+                out << "    }\n";
+                break;
+            }
+        case agi::Instruction::kIf:
+            out << "    if (!(" << ConditionExpression(script, instruction) << ")) {\n";
+            out << "        goto i" << instruction.target << ";\n";
+            out << "    }\n";
+            break;
+        case agi::Instruction::kGoto:
+            out << "    goto i" << instruction.target << ";\n";
+            break;
+        case agi::Instruction::kInvalid:
+            out << "    throw std::runtime_error(\"Invalid instruction in script.\");\n";
+            break;
+        }
+    }
+    out << "i" << count << ":\n";
+    out << "    ip = " << count << ";\n";
+    out << "}\n\n";
+}
+
+void WriteVerifier(std::ostream& out, const std::string& name)
+{
+    out <<
+        "#ifdef AGI_NATIVE_VERIFY\n"
+        "\n"
+        "// Runs the game with and without the translated logics, and compares the\n"
+        "// variables and flags after every cycle.\n"
+        "int main(int argc, char** argv)\n"
+        "{\n"
+        "    if (argc < 2) {\n"
+        "        std::cerr << \"Usage: \" << argv[0] << \" <game directory or archive> [cycles]\" << std::endl;\n"
+        "        return -1;\n"
+        "    }\n"
+        "    const size_t cycles = (argc > 2) ? std::stoul(argv[2]) : 1000;\n"
+        "    agi::InterpreterOptions options;\n"
+        "    agi::Interpreter reference(argv[1], options);\n"
+        "    options.native = &" << name << ";\n"
+        "    agi::Interpreter native(argv[1], options);\n"
+        "    // both interpreters uses the default seed, so they get the same random numbers\n"
+        "    for(size_t i = 0; i < cycles; ++i) {\n"
+        "        reference.StartCycle();\n"
+        "        native.StartCycle();\n"
+        "        if (reference.GetStateChecksum() != native.GetStateChecksum()) {\n"
+        "            std::cerr << \"The state differs after cycle \" << i << std::endl;\n"
+        "            return 1;\n"
+        "        }\n"
+        "    }\n"
+        "    std::cout << \"The state is identical for \" << cycles << \" cycles\" << std::endl;\n"
+        "    return 0;\n"
+        "}\n"
+        "\n"
+        "#endif\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <game directory or archive> <output file> <module name>" << std::endl;
+        return -1;
+    }
+
+    const boost::filesystem::path path(argv[1]);
+    const std::string name(argv[3]);
+    try {
+        std::unique_ptr<agi::VolumeLoader> volumes;
+        std::unique_ptr<agi::ResourceIndex> resources;
+        if (boost::filesystem::is_regular_file(path)) {
+            resources.reset(new agi::ResourceIndex(std::make_shared<agi::GameArchive>(path)));
+        }
+        else {
+            volumes.reset(new agi::VolumeLoader(path));
+            resources.reset(new agi::ResourceIndex(*volumes, path));
+        }
+        agi::ScriptLoader scripts(*resources);
+
+        std::stringstream logics;
+        std::stringstream table;
+        size_t translated = 0;
+        for(unsigned i = 0; i < 256; ++i) {
+            const auto index = static_cast<uint8_t>(i);
+            if (!resources->Contains(agi::ResourceType::kLogic, index)) {
+                table << "        {nullptr, 0},\n";
+                continue;
+            }
+            try {
+                auto script = scripts.GetScript(index);
+                WriteLogic(logics, i, *script);
+                table << "        {Logic" << i << ", 0x"
+                    << std::hex << agi::GetCodeChecksum(script->code) << std::dec << "ull},\n";
+                ++translated;
+            }
+            catch(std::exception& e) {
+                // left to the interpreter
+                std::cerr << "Skipped logic " << i << ": " << e.what() << std::endl;
+                table << "        {nullptr, 0},\n";
+            }
+        }
+
+        boost::filesystem::ofstream out(argv[2]);
+        if (!out) {
+            throw std::runtime_error("Failed to create the output file.");
+        }
+        out << "// Generated by logic2cpp from " << path.filename().string() << ", do not edit.\n";
+        out << "#include <agi/native_module.h>\n";
+        out << "#include <stdexcept>\n";
+        out << "#ifdef AGI_NATIVE_VERIFY\n";
+        out << "#include <agi/interpreter.h>\n";
+        out << "#include <iostream>\n";
+        out << "#include <string>\n";
+        out << "#endif\n\n";
+        out << "namespace {\n\n";
+        out << logics.str();
+        out << "} // namespace\n\n";
+        out << "extern const agi::NativeModule " << name << " = {\n";
+        out << "    \"" << name << "\",\n";
+        out << "    {{\n";
+        out << table.str();
+        out << "    }}\n";
+        out << "};\n\n";
+        WriteVerifier(out, name);
+        std::cout << "Translated " << translated << " logics to " << argv[2] << std::endl;
+    }
+    catch(std::exception& e) {
+        std::cerr << "Caught exception: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include <agi/archive.h>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <game directory> <archive file>" << std::endl;
+        return -1;
+    }
+
+    try {
+        auto summary = agi::WriteGameArchive(argv[1], argv[2]);
+        std::cout << "Wrote " << summary.logics << " logics, "
+            << summary.pictures << " pictures and "
+            << summary.views << " views to " << argv[2] << std::endl;
+        if (summary.skipped) {
+            std::cerr << "Skipped " << summary.skipped
+                << " resources that could not be parsed" << std::endl;
+        }
+    }
+    catch(std::exception& e) {
+        std::cerr << "Caught exception: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
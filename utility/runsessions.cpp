@@ -0,0 +1,233 @@
+#include <agi/interpreter.h>
+#include <agi/thread_pool.h>
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * A session is a text file with one setting or key press per line, lines
+ * starting with # are comments:
+ *
+ *      seed 42             seeds the random numbers, the default is 1
+ *      cycles 5000         the number of cycles to run
+ *      key 120 left        a key press before cycle 120, one of
+ *                          left, up, right, down or other
+ *      key 300 other 32    the code is what the logics sees, default 0
+ */
+
+namespace {
+
+struct KeyPress
+{
+    size_t cycle;
+    agi::KeyEvent event;
+};
+
+struct Session
+{
+    std::string name;
+    uint32_t seed = 1;
+    size_t cycles = 1000;
+    std::vector<KeyPress> keys;     // sorted on the cycle
+};
+
+struct SessionResult
+{
+    size_t cycles = 0;                      // the completed cycles
+    std::chrono::duration<double> time{0};
+    uint64_t checksum = 0;                  // the state after the last cycle
+    std::string error;
+    std::shared_ptr<agi::Profiler> profiler;
+};
+
+agi::Key ParseKey(const std::string& name)
+{
+    if (name == "left") return agi::Key::kLeft;
+    if (name == "up") return agi::Key::kUp;
+    if (name == "right") return agi::Key::kRight;
+    if (name == "down") return agi::Key::kDown;
+    if (name == "other") return agi::Key::kOther;
+    throw std::runtime_error("Unknown key " + name);
+}
+
+Session LoadSession(const boost::filesystem::path& path, size_t defaultCycles)
+{
+    boost::filesystem::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Failed to open the session " + path.string());
+    }
+    Session session;
+    session.name = path.filename().string();
+    session.cycles = defaultCycles;
+    std::string line;
+    while(std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::string keyword;
+        if (!(ss >> keyword) || (keyword[0] == '#')) {
+            continue;
+        }
+        if (keyword == "seed") {
+            ss >> session.seed;
+        }
+        else if (keyword == "cycles") {
+            ss >> session.cycles;
+        }
+        else if (keyword == "key") {
+            KeyPress key;
+            std::string name;
+            unsigned code = 0;
+            ss >> key.cycle >> name >> code;
+            key.event.key = ParseKey(name);
+            key.event.code = static_cast<uint8_t>(code);
+            session.keys.push_back(key);
+        }
+        else {
+            throw std::runtime_error("Unknown keyword " + keyword + " in " + session.name);
+        }
+    }
+    std::stable_sort(session.keys.begin(), session.keys.end(),
+        [](const KeyPress& lhs, const KeyPress& rhs) { return lhs.cycle < rhs.cycle; });
+    return session;
+}
+
+SessionResult RunSession(const std::shared_ptr<agi::GameData>& game, const Session& session, bool profile)
+{
+    SessionResult result;
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        agi::InterpreterOptions options;
+        options.seed = session.seed;
+        if (profile) {
+            // every interpreter has its own profiler, they are merged later
+            result.profiler = std::make_shared<agi::Profiler>();
+            options.profiler = result.profiler;
+        }
+        agi::Interpreter interpreter(game, options);
+
+        auto key = session.keys.begin();
+        while(result.cycles < session.cycles) {
+            // the key presses before the next cycle
+            for(; (key != session.keys.end()) && (key->cycle <= result.cycles); ++key) {
+                interpreter.OnKeyPress(key->event);
+            }
+            const size_t next = (key != session.keys.end()) ?
+                std::min(key->cycle, session.cycles) : session.cycles;
+            const size_t count = next - result.cycles;
+            const size_t completed = interpreter.RunCycles(count);
+            result.cycles += completed;
+            if (completed < count) {
+                throw std::runtime_error("The game requested user action.");
+            }
+        }
+        result.checksum = interpreter.GetStateChecksum();
+    }
+    catch(std::exception& e) {
+        result.error = e.what();
+    }
+    result.time = std::chrono::steady_clock::now() - start;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0]
+            << " <game directory or archive> <session files...> [--threads n] [--cycles n] [--profile name]" << std::endl;
+        return -1;
+    }
+
+    const boost::filesystem::path game(argv[1]);
+    size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    size_t cycles = 1000;
+    std::string profile;
+    std::vector<boost::filesystem::path> files;
+    for(int i = 2; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        if ((arg == "--threads") && ((i + 1) < argc)) {
+            threads = std::stoul(argv[++i]);
+        }
+        else if ((arg == "--cycles") && ((i + 1) < argc)) {
+            cycles = std::stoul(argv[++i]);
+        }
+        else if ((arg == "--profile") && ((i + 1) < argc)) {
+            profile = argv[++i];
+            if (!agi::kProfilerEnabled) {
+                std::cerr << "Built without AGI_ENABLE_PROFILER, the profile will be empty." << std::endl;
+            }
+        }
+        else {
+            files.push_back(arg);
+        }
+    }
+
+    std::vector<Session> sessions;
+    try {
+        for(auto& file : files) {
+            sessions.push_back(LoadSession(file, cycles));
+        }
+    }
+    catch(std::exception& e) {
+        std::cerr << "Caught exception: " << e.what() << std::endl;
+        return -1;
+    }
+
+    // the sessions share the resources, but every session has an
+    // interpreter of its own
+    std::shared_ptr<agi::GameData> data;
+    try {
+        data = std::make_shared<agi::GameData>(game);
+    }
+    catch(std::exception& e) {
+        std::cerr << "Failed to load the game: " << e.what() << std::endl;
+        return -1;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<SessionResult> > pending;
+    {
+        agi::ThreadPool pool(threads);
+        for(auto& session : sessions) {
+            pending.push_back(pool.Submit([&data, &session, &profile]() {
+                return RunSession(data, session, !profile.empty());
+            }));
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    size_t totalCycles = 0;
+    size_t failed = 0;
+    agi::Profiler profiler;
+    for(size_t i = 0; i < sessions.size(); ++i) {
+        const auto result = pending[i].get();
+        totalCycles += result.cycles;
+        if (result.profiler) {
+            profiler.Merge(*result.profiler);
+        }
+        std::cout << sessions[i].name << ": " << result.cycles << " cycles, "
+            << static_cast<uint64_t>(result.time.count() * 1000) << " ms, ";
+        if (result.error.empty()) {
+            std::cout << "state " << std::hex << std::setw(16) << std::setfill('0')
+                << result.checksum << std::dec << std::setfill(' ') << std::endl;
+        }
+        else {
+            std::cout << "failed: " << result.error << std::endl;
+            ++failed;
+        }
+    }
+    std::cout << sessions.size() << " sessions on " << threads << " threads, "
+        << static_cast<uint64_t>(totalCycles / elapsed.count()) << " cycles/s" << std::endl;
+    if (!profile.empty()) {
+        boost::filesystem::ofstream report(profile + ".txt");
+        profiler.WriteReport(report);
+        boost::filesystem::ofstream csv(profile + ".csv");
+        profiler.WriteCsv(csv);
+    }
+    return failed ? 1 : 0;
+}
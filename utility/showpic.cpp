@@ -1,36 +1,12 @@
-#include <agi/directory.h>
-#include <agi/volume.h>
+#include <agi/resource_index.h>
 #include <agi/logic.h>
 #include <agi/picture.h>
 #include <iostream>
-#include <map>
-#include <sstream>
 #include <SDL.h>
 
 #define WINDOW_WIDTH (800)
 #define WINDOW_HEIGHT (1000)
 
-using VolumeCache = std::map<unsigned, std::shared_ptr<agi::Volume> >;
-
-std::shared_ptr<agi::Volume> FindVolume(
-    const std::string& basepath, unsigned volume, VolumeCache& cache)
-{
-    auto it = cache.find(volume);
-    if (it != cache.end()) {
-        return it->second;
-    }
-    else {
-        std::stringstream ss;
-        ss << basepath << "/VOL." << volume;
-        auto result = agi::LoadVolume(ss.str());
-        if (result) {
-            // found the volume, store it in the cache
-            cache[volume] = result;
-        }
-        return result;
-    }
-}
-
 static uint32_t ColorTable[] = {
     0xFF000000, // black
     0xFFAA0000, // blue
@@ -77,31 +53,21 @@ void DrawPictureToSurface(
 
 bool RenderPicture(const std::string& basepath, size_t pictureIndex, agi::Framebuffer& framebuffer)
 {
-    // first load the script directory
-    std::vector<agi::DirectoryEntry> directory;
+    if (pictureIndex > 255) {
+        return false;
+    }
     try {
-        const std::string logdir = basepath + "/PICDIR";
-        agi::ParseDirectoryFile(logdir, directory);
+        agi::VolumeLoader volumes(basepath);
+        agi::ResourceIndex resources(volumes, basepath);
+        auto data = resources.Get(agi::ResourceType::kPicture, static_cast<uint8_t>(pictureIndex));
+        agi::Source source(data.data(), data.size());
+        agi::DrawPicture(source, framebuffer);
+        return true;
     }
     catch(std::exception& e) {
         std::cerr << "Caught exception: " << e.what() << std::endl;
         return false;
     }
-
-    VolumeCache cache;
-    if (pictureIndex < directory.size()) {
-        const auto& entry = directory.at(pictureIndex);
-        if (auto volume = FindVolume(basepath, entry.volume, cache)) {
-            if (entry.offset < volume->data.size()) {
-                agi::DrawPictureResource(volume->data, entry.offset, framebuffer);
-                return true;
-            }
-            else {
-                return false;
-            }
-        }
-    }
-    return false;
 }
 
 int main(int argc, char** argv)
@@ -1,37 +1,13 @@
-#include <agi/directory.h>
-#include <agi/volume.h>
+#include <agi/resource_index.h>
 #include <agi/logic.h>
 #include <agi/picture.h>
 #include <agi/view.h>
 #include <iostream>
-#include <map>
-#include <sstream>
 #include <SDL.h>
 
 #define WINDOW_WIDTH (800)
 #define WINDOW_HEIGHT (1000)
 
-using VolumeCache = std::map<unsigned, std::shared_ptr<agi::Volume> >;
-
-std::shared_ptr<agi::Volume> FindVolume(
-    const std::string& basepath, unsigned volume, VolumeCache& cache)
-{
-    auto it = cache.find(volume);
-    if (it != cache.end()) {
-        return it->second;
-    }
-    else {
-        std::stringstream ss;
-        ss << basepath << "/VOL." << volume;
-        auto result = agi::LoadVolume(ss.str());
-        if (result) {
-            // found the volume, store it in the cache
-            cache[volume] = result;
-        }
-        return result;
-    }
-}
-
 static uint32_t ColorTable[] = {
     0xFF000000, // black
     0xFFAA0000, // blue
@@ -84,6 +60,7 @@ SDL_Surface* DrawLoop(const agi::Loop& loop, size_t loopIndex)
     // now paint each cel, start with x = 0
     size_t penPosition = 0;
     for(auto& cel : loop.cels) {
+        const auto pixels = cel.GetPixels();
         // draw the cel at (position, 0)
         for(uint8_t y = 0; y < cel.height; ++y) {
             uint32_t* ptr = reinterpret_cast<uint32_t*>(
@@ -94,11 +71,11 @@ SDL_Surface* DrawLoop(const agi::Loop& loop, size_t loopIndex)
                 uint8_t pixel;
                 if (cel.mirrored && (cel.mirrorLoop != loopIndex)) {
                     // draw mirrored 
-                    pixel = cel.pixels[(y * cel.width) + (cel.width - x - 1)];
+                    pixel = pixels[(y * cel.width) + (cel.width - x - 1)];
                 }
                 else {
                     // draw normal
-                    pixel = cel.pixels[(y * cel.width) + x];
+                    pixel = pixels[(y * cel.width) + x];
                 }
                 if (pixel != cel.colorKey) {
                     // not transparent, so draw the pixel
@@ -117,43 +94,24 @@ SDL_Surface* DrawLoop(const agi::Loop& loop, size_t loopIndex)
 
 std::vector<SDL_Surface*> DrawView(const std::string& basepath, size_t viewIndex)
 {
-    std::vector<agi::DirectoryEntry> directory;
-    try {
-        const std::string logdir = basepath + "/VIEWDIR";
-        agi::ParseDirectoryFile(logdir, directory);
-    }
-    catch(std::exception& e) {
-        assert(false);
-        std::cerr << "Caught exception: " << e.what() << std::endl;
-        throw;
+    std::vector<SDL_Surface*> result;
+    if (viewIndex > 255) {
+        return result;
     }
 
-    std::vector<SDL_Surface*> result;   
-    VolumeCache cache;
-    if (viewIndex < directory.size()) {
-        const auto& entry = directory.at(viewIndex);
-        if (auto volume = FindVolume(basepath, entry.volume, cache)) {
-            if (entry.offset < volume->data.size()) {
-                agi::Source source(volume->data.data(), volume->data.size(), entry.offset);
-                
-                agi::View view;
-                agi::ParseViewResource(source, view);
-
-                for(size_t i = 0; i < view.loops.size(); ++i) {
-                    if (auto surface = DrawLoop(view.loops[i], i)) {
-                        result.push_back(surface);
-                    }
-                }
-            }
-            else {
-                assert(false);
-            }
-        }
-        else {
-            assert(false);
+    agi::VolumeLoader volumes(basepath);
+    agi::ResourceIndex resources(volumes, basepath);
+    auto data = resources.Get(agi::ResourceType::kView, static_cast<uint8_t>(viewIndex));
+    agi::Source source(data.data(), data.size());
+
+    agi::View view;
+    agi::ParseView(source, view);
+
+    for(size_t i = 0; i < view.loops.size(); ++i) {
+        if (auto surface = DrawLoop(view.loops[i], i)) {
+            result.push_back(surface);
         }
     }
-
     return result;
 }
 